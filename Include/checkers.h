@@ -1,11 +1,24 @@
 ﻿#ifndef CHECKERSBOARD_H
 #define CHECKERSBOARD_H
 
+#include <cassert>
 #include <vector>
 #include <string>
 #include <iostream>
 #include <thread>
 #include <limits>
+#include <cstdint>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include "transposition.h"
+#include "tablebase.h"
+#include "opening_book.h"
+#include "evaluation.h"
+
+class MonteCarloTree;
 
 // Типы для шашек
 enum class Piece {
@@ -26,60 +39,431 @@ struct Coord {
     }
 };
 
-// Ход (цепочка клеток)
+// Координаты тёмной клетки s = r * 4 + c / 2
+inline Coord darkSquareCoord(int s) {
+    int r = s / 4;
+    return Coord(r, 2 * (s % 4) + ((r % 2 == 0) ? 1 : 0));
+}
+
+// Шашек у стороны не больше, чем в начальной позиции;
+// parsePosition другие позиции не принимает
+const int MAX_SIDE_PIECES = 12;
+
+// Ход (цепочка клеток) без выделения памяти: номера тёмных клеток пути
+// и маска срубленных шашек. Тривиально копируется.
 struct Move {
-    std::vector<Coord> path;
-    Move() {}
-    Move(const std::vector<Coord>& p) : path(p) {}
+    // Цепочка рубки берёт не больше MAX_SIDE_PIECES шашек: 13 клеток пути
+    static const int MAX_PATH = 16;
+    static_assert(MAX_PATH > MAX_SIDE_PIECES, "a capture chain must fit in the path");
+
+    uint8_t path[MAX_PATH] = {};
+    uint8_t length = 0;
+    uint32_t captured = 0;  // заполняет генератор ходов
+
+    Coord from() const { return darkSquareCoord(path[0]); }
+    Coord to()   const { return darkSquareCoord(path[length - 1]); }
+    Coord at(size_t i) const { return darkSquareCoord(path[i]); }
+    int fromSquare() const { return path[0]; }
+    int toSquare() const { return path[length - 1]; }
+    size_t size() const { return length; }
+
+    void push(int s) {
+        assert(length < MAX_PATH);
+        path[length++] = static_cast<uint8_t>(s);
+    }
+    void pop() { --length; }
+
+    // Ходы равны, если совпадает путь
+    bool operator==(const Move& other) const {
+        if (length != other.length) return false;
+        for (int i = 0; i < length; ++i) {
+            if (path[i] != other.path[i]) return false;
+        }
+        return true;
+    }
+};
+
+// Список ходов на стеке. Элементы не инициализируются при создании списка,
+// поэтому заводить его в каждом узле поиска дёшево. Больше CAPACITY ходов
+// (длинные рубки дамкой с выбором клеток приземления) список переносит
+// в кучу: ходы никогда не теряются, а обычные позиции памяти не выделяют.
+class MoveList {
+public:
+    static const int CAPACITY = 256;
+
+    MoveList() : data(items), count(0), capacity(CAPACITY) {}
+    MoveList(const MoveList& other) : MoveList() { *this = other; }
+    MoveList& operator=(const MoveList& other) {
+        if (this != &other) {
+            count = 0;
+            while (capacity < other.count) {
+                grow();
+            }
+            std::copy(other.data, other.data + other.count, data);
+            count = other.count;
+        }
+        return *this;
+    }
+
+    void push_back(const Move& mv) {
+        if (count == capacity) {
+            grow();
+        }
+        data[count++] = mv;
+    }
+    void clear() { count = 0; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Move& operator[](size_t i) { return data[i]; }
+    const Move& operator[](size_t i) const { return data[i]; }
+    Move* begin() { return data; }
+    Move* end() { return data + count; }
+    const Move* begin() const { return data; }
+    const Move* end() const { return data + count; }
 
-    Coord from() const { return path.front(); }
-    Coord to()   const { return path.back(); }
-    size_t size() const { return path.size(); }
+private:
+    Move* data;
+    size_t count;
+    size_t capacity;
+    std::unique_ptr<Move[]> spill;
+    union {
+        Move items[CAPACITY];
+    };
+
+    void grow();
+};
+
+// Значения по ходам списка (оценки, порядок перебора): на стеке для
+// списков до MoveList::CAPACITY ходов, для длинных — в куче
+template<typename T>
+class MoveBuffer {
+public:
+    explicit MoveBuffer(size_t size) : data(local) {
+        if (size > MoveList::CAPACITY) {
+            heap.reset(new T[size]);
+            data = heap.get();
+        }
+    }
+    MoveBuffer(const MoveBuffer&) = delete;
+    MoveBuffer& operator=(const MoveBuffer&) = delete;
+
+    T& operator[](size_t i) { return data[i]; }
+    const T& operator[](size_t i) const { return data[i]; }
+    T* get() { return data; }
+
+private:
+    T local[MoveList::CAPACITY];
+    std::unique_ptr<T[]> heap;
+    T* data;
+};
+
+// Данные для отката хода (makeMoveUnchecked -> unmakeMove)
+struct Undo {
+    uint32_t captured = 0;       // срубленные шашки соперника
+    uint32_t capturedKings = 0;  // какие из срубленных были дамками
+    int8_t from = 0, to = 0;     // исходная и конечная клетки (0..31)
+    bool promoted = false;       // ход закончился превращением в дамку
+    uint64_t key = 0;            // ключ Зобриста до хода
+    int eval = 0;                // оценка до хода
+};
+
+// Промежуточный итог поиска: у альфа-беты — после каждой завершённой
+// итерации, у поиска Монте-Карло — раз в несколько тысяч розыгрышей
+struct SearchProgress {
+    Move bestMove;
+    int depth = 0;
+    int score = 0;           // с точки зрения белых, как в SearchResult
+    uint64_t nodes = 0;      // узлов (розыгрышей) основного потока с начала поиска
+    double seconds = 0.0;
+    std::vector<Move> pv;
+};
+
+// Ограничения поиска
+struct SearchLimits {
+    int depth = 64;                          // максимальная глубина итераций
+    std::chrono::milliseconds budget{ 0 };   // 0 — без ограничения по времени
+    int threads = 0;                         // потоков поиска; 0 — доля общего пула на поиск
+    std::atomic<bool>* stop = nullptr;       // внешний флаг остановки (отмена извне)
+    // Вызывается в потоке, который ведёт поиск (пустой — не вызывается)
+    std::function<void(const SearchProgress&)> progress;
+};
+
+// Выборочный поиск (у каждой доски свои настройки). Сокращения и отсечения
+// касаются только тихих ходов: рубки, превращения и ходы, после которых
+// соперник обязан рубить, всегда ищутся на полную глубину. Вблизи оценок
+// выигрыша выборочность отключается.
+struct SearchOptions {
+    // Сокращение поздних ходов (LMR): тихий ход с номером >= lmrMinMoves при
+    // глубине >= lmrMinDepth ищется на lmrReduction полуходов мельче;
+    // если он всё же лучше alpha, перепроверяется на полной глубине
+    bool lateMoveReductions = true;
+    int lmrMinDepth = 3;
+    int lmrMinMoves = 3;
+    int lmrReduction = 1;
+
+    // Отсечение бесперспективных ходов: на глубине 1..2 тихие ходы не ищутся,
+    // если статическая оценка + futilityMargin[глубина] не дотягивает до alpha
+    bool futilityPruning = true;
+    int futilityMargin[3] = { 0, 80, 160 };
+
+    // Ограниченный razoring: на глубине 3 при оценке + razorMargin <= alpha
+    // узел ищется на полуход мельче
+    bool razoring = true;
+    int razorMargin = 300;
+
+    // Полный перебор без выборочности
+    static SearchOptions fullWidth() {
+        SearchOptions options;
+        options.lateMoveReductions = false;
+        options.futilityPruning = false;
+        options.razoring = false;
+        return options;
+    }
+};
+
+// Итерация углубления основного потока
+struct DepthStats {
+    int depth = 0;
+    int score = 0;
+    uint64_t nodes = 0;    // узлы основного потока за итерацию
+    double seconds = 0.0;  // время итерации
+};
+
+// Статистика поиска; у каждого потока своя, сводится в конце
+struct SearchStats {
+    uint64_t nodes = 0;             // узлы всех потоков (minimax и продление рубками)
+    uint64_t quiescenceNodes = 0;   // узлы продления рубками на горизонте
+    uint64_t betaCutoffs = 0;
+    uint64_t firstMoveCutoffs = 0;  // отсечение дал первый же ход
+    uint64_t ttProbes = 0;
+    uint64_t ttHits = 0;
+    int maxCaptureChain = 0;        // больше всего шашек, снятых одним ходом в дереве
+    uint64_t reductions = 0;        // ходов, искавшихся с сокращением (LMR)
+    uint64_t reSearches = 0;        // из них перепроверено на полной глубине
+    uint64_t futilityPrunes = 0;    // тихих ходов, отсечённых на горизонте
+    uint64_t razorings = 0;         // узлов, сокращённых razoring
+    double seconds = 0.0;
+    std::vector<DepthStats> depths; // только основной поток
+
+    // Доля отсечений на первом ходу — главный показатель качества упорядочивания
+    double firstMoveCutoffRate() const {
+        return betaCutoffs ? static_cast<double>(firstMoveCutoffs) / betaCutoffs : 0.0;
+    }
+    double ttHitRate() const {
+        return ttProbes ? static_cast<double>(ttHits) / ttProbes : 0.0;
+    }
+    // Эффективный коэффициент ветвления: отношение узлов двух последних итераций
+    double effectiveBranchingFactor() const {
+        if (depths.size() < 2 || depths[depths.size() - 2].nodes == 0) {
+            return 0.0;
+        }
+        return static_cast<double>(depths.back().nodes) / depths[depths.size() - 2].nodes;
+    }
+    // Счётчики складываются, итерации остаются свои
+    void merge(const SearchStats& other) {
+        nodes += other.nodes;
+        quiescenceNodes += other.quiescenceNodes;
+        betaCutoffs += other.betaCutoffs;
+        firstMoveCutoffs += other.firstMoveCutoffs;
+        ttProbes += other.ttProbes;
+        ttHits += other.ttHits;
+        maxCaptureChain = std::max(maxCaptureChain, other.maxCaptureChain);
+        reductions += other.reductions;
+        reSearches += other.reSearches;
+        futilityPrunes += other.futilityPrunes;
+        razorings += other.razorings;
+    }
+    // Одна строка JSON
+    std::string toJson() const;
+};
+
+// Результат поиска; оценка с точки зрения белых
+struct SearchResult {
+    Move bestMove;
+    int score = 0;
+    int depth = 0;          // последняя полностью завершённая глубина
+    uint64_t nodes = 0;
+    std::vector<Move> pv;   // главный вариант, начиная с bestMove
+    SearchStats stats;
 };
 
 class CheckersBoard {
 public:
     static const int BOARD_SIZE = 8;
+    // Число тёмных (игровых) клеток: s = r * 4 + c / 2
+    static const int NUM_SQUARES = 32;
 
     CheckersBoard();
     void initBoard();
     std::string pieceToString(Piece p) const;
     void printBoard();
+    Piece pieceAt(int r, int c) const;
     bool isWhiteToMove() const;
     void setWhiteToMove(bool w);
 
+    // Ключ Зобриста позиции, обновляется инкрементально в makeMoveUnchecked
+    uint64_t hash() const { return hashKey; }
+    uint64_t computeHash() const;
+
+    // Таблица транспозиций для поиска (по умолчанию общая для процесса)
+    void setTranspositionTable(TranspositionTable* table) { tt = table; }
+    TranspositionTable* transpositionTable() const { return tt; }
+
+    // Таблицы окончаний (по умолчанию общие для процесса; пустые, пока не загружены)
+    void setTablebases(const Tablebases* tables) { tb = tables; }
+    const Tablebases* tablebases() const { return tb; }
+
+    // Дебютная книга для getBestMove (по умолчанию общая; nullptr — не использовать)
+    void setOpeningBook(const OpeningBook* openingBook) { book = openingBook; }
+    const OpeningBook* openingBook() const { return book; }
+
+    // Поиск Монте-Карло вместо альфа-беты (по умолчанию nullptr — альфа-бета).
+    // Дерево не копируется вместе с доской: одновременно искать в нём может только одна доска
+    void setMonteCarloTree(MonteCarloTree* tree) { mcts = tree; }
+    MonteCarloTree* monteCarloTree() const { return mcts; }
+
+    // Выборочный поиск (по умолчанию включён, см. SearchOptions)
+    void setSearchOptions(const SearchOptions& options) { selectivity = options; }
+    const SearchOptions& searchOptions() const { return selectivity; }
+
+    // Вариант оценочной функции (по умолчанию полная)
+    void setEvalVariant(EvalVariant variant) { evalVariant = variant; }
+    EvalVariant evaluationVariant() const { return evalVariant; }
+
+    // Битборды позиции: бит s — тёмная клетка s
+    uint32_t whitePieces() const { return whiteBB; }
+    uint32_t blackPieces() const { return blackBB; }
+    uint32_t kingPieces() const { return kingsBB; }
+    // Расстановка из битбордов (без проверок), ключ пересчитывается
+    void setPosition(uint32_t white, uint32_t black, uint32_t kings, bool whiteMoves);
+
     bool canCurrentPlayerMove();
-    std::vector<Move> getAllPossibleMoves(bool whiteSide);
+    MoveList getAllPossibleMoves(bool whiteSide);
 
+    // Проверенный ход (ввод пользователя): false, если ход не разрешён
     bool makeMove(const Move& move);
+    // Быстрый путь для ходов из getAllPossibleMoves, без проверок
+    Undo makeMoveUnchecked(const Move& move);
+    void unmakeMove(const Undo& undo);
 
-    // Оценочная функция
+    // Оценочная функция (с точки зрения белых, см. Evaluation): клеточная часть
+    // ведётся инкрементально в makeMoveUnchecked, подвижность считается по маскам
     int evaluateBoard() const;
+    // Клеточная часть оценки полным пересчётом (при расстановке и для проверки)
+    int computeEvaluation() const;
 
-    // Minimax c альфа-бета отсечением и многопоточностью
+    // Альфа-бета на заданную глубину за сторону maximizingPlayer (true — белые),
+    // оценка с точки зрения белых; внутри — negamax
     int minimax(int depth, int alpha, int beta, bool maximizingPlayer);
 
-    // Вернуть лучший ход для текущего whiteToMove
+    // Вернуть лучший ход для текущего whiteToMove: сперва из дебютной книги, затем поиском
     Move getBestMove(int depth);
+    Move getBestMove(std::chrono::milliseconds budget);
+
+    // Итеративное углубление с ограничениями по глубине и времени
+    // (или поиск Монте-Карло, если задано дерево)
+    SearchResult search(const SearchLimits& limits);
+
+    // Ход из дебютной книги для текущей позиции (случайный с вероятностью по весу)
+    bool bookMove(Move& move);
+
+    // Статистика последнего поиска этой доски
+    const SearchStats& lastSearchStats() const { return lastStats; }
+    // Куда писать строку JSON с результатом и статистикой после каждого поиска (nullptr — никуда)
+    void setStatsOutput(std::ostream* out) { statsOutput = out; }
+    // Строка JSON итога поиска этой позиции в вывод статистики (если он задан);
+    // поиск пишет её сам, нужна для поиска, прошедшего на копии доски без вывода
+    void writeStats(const SearchResult& result) const;
 
     // Парсим ввод вида "A3 B4" -> путь
     bool parseUserMove(const std::string& input, Move& move);
+    static std::string moveToString(const Move& move);
+
+    // Текстовая запись позиции: "W W:B1,D1 B:A6 DW:E5 DB:" (сторона хода и группы шашек)
+    bool parsePosition(const std::string& text);
+    std::string toPositionString() const;
+
+    // Перевод (r,c) <-> номер тёмной клетки; для светлой клетки -1
+    static int squareIndex(int r, int c);
+    static Coord squareCoord(int s);
 
 private:
-    std::vector<std::vector<Piece>> board;
+    // Битборды: бит s соответствует тёмной клетке s
+    uint32_t whiteBB;   // все белые шашки (простые и дамки)
+    uint32_t blackBB;   // все чёрные шашки
+    uint32_t kingsBB;   // дамки обоих цветов
     bool whiteToMove;
+    uint64_t hashKey;
+    int evalScore;
+    TranspositionTable* tt;
+    const Tablebases* tb;
+    const OpeningBook* book;
+    MonteCarloTree* mcts;
+    EvalVariant evalVariant;
+    SearchOptions selectivity;
+    SearchStats lastStats;
+    std::ostream* statsOutput;
+
+    static constexpr int MAX_PLY = 128;
+    static constexpr int HISTORY_LIMIT = 1 << 28;  // ниже оценки ходов-убийц в orderMoves
+
+    // Состояние текущего поиска (у каждого потока своё, флаг остановки общий)
+    struct SearchControl {
+        std::chrono::steady_clock::time_point deadline;
+        bool timeLimited = false;
+        std::atomic<bool>* stop = nullptr;          // свой флаг поиска, общий для его потоков
+        std::atomic<bool>* externalStop = nullptr;  // limits.stop: только читается
+        const SearchLimits* limits = nullptr;  // только у основного потока: для progress
+        std::chrono::steady_clock::time_point start;
+        std::vector<uint64_t> pvKeys;  // позиции главного варианта по ply
+        std::vector<int> pvMoves;      // и номера ходов в них
+        uint16_t killers[MAX_PLY][2] = {};  // тихие ходы, давшие отсечение (from << 8 | to)
+        int history[NUM_SQUARES][NUM_SQUARES] = {};  // таблица истории [from][to]
+        SearchStats stats;
+    };
+    SearchControl* control = nullptr;
+    uint64_t searchNodes = 0;
+
+    bool searchAborted();
+    static uint16_t quietMoveKey(const Move& move);
+    void orderMoves(const MoveList& moves, int hashMove, int ply, int* order) const;
+    void noteCutoff(const Move& move, int moveNumber, int depth, int ply);
+    // Поиск специализирован по стороне хода White (== whiteToMove)
+    template<bool White> int negamax(int depth, int alpha, int beta, int ply);
+    template<bool White> int quiescence(int alpha, int beta, int ply);
+    int searchRoot(const MoveList& moves, int depth, int alpha, int beta, int& bestScore);
+    bool probeTablebases(int ply, int& score) const;
+    bool tablebaseRootMove(const MoveList& moves, SearchResult& result);
+    void noteCaptures(const MoveList& moves);
+    void finishSearch(SearchResult& result, std::chrono::steady_clock::time_point start);
+    SearchResult iterativeDeepening(MoveList moves, int maxDepth, int firstDepth);
+    void extractPv(const Move& first, int maxLength, std::vector<Move>& pv);
+
+    uint32_t occupiedBB() const { return whiteBB | blackBB; }
+    uint32_t sideBB(bool whiteSide) const { return whiteSide ? whiteBB : blackBB; }
+    void setPiece(int s, Piece p);
+
+    bool hasCapture(bool whiteSide) const;
 
-    bool isValidPos(int r, int c) const;
-    bool isColor(Piece p, bool whiteSide) const;
+    // Генерация ходов и makeMove/unmakeMove, специализированные по стороне White:
+    // направления простых, поле превращения и свои/чужие маски известны при компиляции.
+    // Публичные getAllPossibleMoves, hasCapture, makeMoveUnchecked и unmakeMove
+    // выбирают специализацию по стороне
+    template<bool White> MoveList generateMoves();
+    template<bool White> bool hasCaptureFor() const;
+    template<bool White> Undo makeMoveFor(const Move& move);
+    template<bool White> void unmakeMoveFor(const Undo& undo);
 
     // Генерация возможных рубок (цепочек) для одной шашки
-    void getAllCapturesForPiece(int r, int c, std::vector<Move>& captures);
+    template<bool White> void getAllCapturesForPiece(int s, MoveList& captures);
 
-    // Рекурсивный поиск всех цепочек рубки
-    void dfsCaptures(std::vector<Coord>& path, std::vector<Move>& results);
+    // Рекурсивный поиск всех цепочек рубки для простой или дамки (King).
+    // path — строящийся ход, enemy/occupied — маски с уже снятыми по ходу цепочки шашками
+    template<bool King> void dfsCaptures(Move& path, uint32_t enemy, uint32_t occupied, MoveList& results);
 
     // Генерация обычных ходов (без рубки)
-    void getAllNormalMovesForPiece(int r, int c, std::vector<Move>& moves);
+    template<bool White> void getAllNormalMovesForPiece(int s, MoveList& moves);
 };
 
 #endif // CHECKERSBOARD_H
\ No newline at end of file
@@ -0,0 +1,125 @@
+﻿#ifndef DFPN_H
+#define DFPN_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+#include "checkers.h"
+
+// Точный результат позиции для стороны хода
+struct SolveResult {
+    bool solved = false;     // false — вышло время или поиск остановлен
+    WDL result = WDL::DRAW;
+    Move bestMove;           // выигрывающий (при ничьей — удерживающий) ход; при проигрыше — первый
+    uint64_t proofSize = 0;  // различных позиций в дереве доказательства (при ничьей — в обоих)
+    uint64_t nodes = 0;      // вызовов поиска
+    int collections = 0;     // сборок мусора в таблице доказательств
+    double seconds = 0.0;
+};
+
+// Решатель df-pn (поиск в глубину по числам доказательства и опровержения).
+//
+// Результат точный в смысле правила ничьей: партия ничья, если drawPlies
+// полуходов подряд не было ни рубки, ни хода простой. Эти ходы необратимы,
+// а узел поиска — позиция вместе со счётчиком полуходов, поэтому граф поиска
+// без циклов и результат узла не зависит от пути к нему.
+// Выигрыш, проигрыш или ничья — это два доказательства: «сторона хода
+// выигрывает» и, если нет, «сторона хода не проигрывает».
+//
+// Результат монотонен по счётчику: стороне, для которой ничья — успех,
+// больший счётчик не мешает. Поэтому решённость хранится на позицию —
+// границы счётчика, с которых цель доказана и до которых опровергнута, —
+// и переносится на узлы с другим счётчиком; числа поиска — на узел.
+// Позиции из загруженных таблиц окончаний (Tablebases доски) — листья.
+// Размер таблицы фиксирован: корзины по 4 записи, при нехватке места
+// вытесняется запись с наименьшей работой. Когда таблица заполнена на 3/4,
+// сборка мусора удаляет нерешённые записи с работой не больше медианы
+// (решённые — и есть доказательство).
+class ProofNumberSolver {
+public:
+    static const int DEFAULT_DRAW_PLIES = 60;
+
+    explicit ProofNumberSolver(size_t megabytes = 64);
+
+    ProofNumberSolver(const ProofNumberSolver&) = delete;
+    ProofNumberSolver& operator=(const ProofNumberSolver&) = delete;
+
+    // Размер таблицы доказательств; содержимое при этом теряется
+    void resize(size_t megabytes);
+    void clear();
+
+    // Правило ничьей (1..255 полуходов без рубок и ходов простыми)
+    void setDrawPlies(int plies) { drawPlies = plies; }
+    int drawLimit() const { return drawPlies; }
+
+    // Решить позицию доски; quietPlies — полуходов без прогресса до неё.
+    // Из limits используются только budget и stop.
+    SolveResult solve(const CheckersBoard& board, const SearchLimits& limits, int quietPlies = 0);
+
+private:
+    // Запись узла (ключ позиции со счётчиком) хранит числа в форме negamax:
+    // phi — стороне хода достичь цели, delta — цель недостижима.
+    // Запись позиции (ключ Зобриста) — границы решённости в «выгодности»
+    // счётчика для стороны хода (см. goodness).
+    struct Entry {
+        uint64_t key = 0;
+        uint32_t phi = 0;
+        uint32_t delta = 0;
+        uint32_t work = 0;         // вызовов поиска в поддереве
+        int16_t provenFrom = 256;  // цель доказана при goodness >= provenFrom
+        int16_t disprovenTo = -1;  // и опровергнута при goodness <= disprovenTo
+        bool used = false;
+
+        bool solved() const { return provenFrom <= 255 || disprovenTo >= 0; }
+    };
+    struct Bucket {
+        Entry entries[4];
+    };
+    struct Child {
+        Move move;
+        uint64_t key;        // ключ позиции после хода
+        int quiet;           // полуходов без прогресса после хода
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucketCount = 0;
+    size_t stored = 0;
+    int drawPlies = DEFAULT_DRAW_PLIES;
+
+    // Состояние текущего решения
+    CheckersBoard board;
+    bool proverWhite = true;   // сторона, чья цель — у корня
+    bool drawIsWin = false;    // вторая фаза: ничья — успех доказывающего
+    bool tablebaseDecisive = false;  // выигрыш и проигрыш из таблиц укладываются в правило
+    std::vector<Child> children;  // дети всех узлов текущего пути подряд
+    uint64_t nodes = 0;
+    int collections = 0;
+    bool aborted = false;
+    std::chrono::steady_clock::time_point deadline;
+    bool timeLimited = false;
+    std::atomic<bool>* stop = nullptr;
+
+    uint64_t nodeKey(int quiet) const;
+    bool drawSucceeds(bool whiteToMove) const;
+    int goodness(int quiet, bool whiteToMove) const;
+    Entry* probe(uint64_t key) const;
+    Entry& slotFor(uint64_t key);
+    bool tablebaseLeaf(int quiet, bool& success) const;
+    bool lookup(uint64_t key, int quiet, bool whiteToMove, uint32_t& phi, uint32_t& delta) const;
+    void store(uint64_t key, int quiet, bool whiteToMove, uint32_t phi, uint32_t delta, uint32_t work);
+    void collectGarbage();
+    size_t generateChildren(int quiet);
+    void mid(int quiet, uint32_t thPhi, uint32_t thDelta);
+    bool prove(int quiet);
+    bool solveChild(size_t index, uint32_t& phi, uint32_t& delta);
+    size_t provingChild(size_t first, size_t count);
+    bool winningMove(int quiet, Move& move);
+    uint64_t proofSize(int quiet, std::unordered_set<uint64_t>& seen);
+    bool checkLimits();
+};
+
+#endif // DFPN_H
@@ -0,0 +1,25 @@
+﻿#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <future>
+#include <stop_token>
+#include "checkers.h"
+
+// Асинхронный отменяемый поиск — вход библиотеки checkers_engine для
+// встраивания движка: сервера многих одновременных партий, интерфейса,
+// консольной игры task1. Вызов не блокирует: поиск идёт в отдельном потоке,
+// помощники Lazy SMP — в общем пуле потоков.
+//
+// Позиция копируется вместе с настройками доски: таблицей транспозиций,
+// таблицами окончаний, деревом Монте-Карло, выборочностью и оценкой.
+// Одновременные поиски могут делить таблицу транспозиций (запись без
+// блокировок), но дерево Монте-Карло у каждого должно быть своё.
+// Дебютная книга не используется — её ход даёт CheckersBoard::bookMove.
+//
+// Отмена — запрос остановки на stop (limits.stop при этом не используется):
+// поиск прерывается в ближайшей проверке, а future получает лучший ход
+// последней завершённой итерации. limits.progress вызывается в потоке поиска.
+std::future<SearchResult> startSearch(const CheckersBoard& position, SearchLimits limits,
+    std::stop_token stop = {});
+
+#endif // ENGINE_H
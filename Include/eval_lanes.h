@@ -0,0 +1,245 @@
+﻿#ifndef EVAL_LANES_H
+#define EVAL_LANES_H
+
+// Внутренний заголовок Source/evaluation*.cpp: формула оценки, записанная
+// один раз над «полосами» — uint32_t, SSE2 (4 позиции) или AVX2 (8 позиций).
+// Всё в безымянном пространстве имён: каждая единица трансляции получает
+// свою копию, собранную со своими флагами, и копии не смешиваются при компоновке.
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include "evaluation.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EVAL_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define EVAL_HAS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Маски признаков для белых и повёрнутые для чёрных
+constexpr size_t FEATURE_COUNT = sizeof(Evaluation::FEATURES) / sizeof(Evaluation::FEATURES[0]);
+
+struct FeatureMasks {
+    uint32_t white[FEATURE_COUNT];
+    uint32_t black[FEATURE_COUNT];
+};
+
+constexpr FeatureMasks buildFeatureMasks() {
+    FeatureMasks m{};
+    for (size_t i = 0; i < FEATURE_COUNT; ++i) {
+        m.white[i] = Evaluation::FEATURES[i].mask;
+        m.black[i] = Evaluation::rotate(Evaluation::FEATURES[i].mask);
+    }
+    return m;
+}
+
+constexpr FeatureMasks FEATURE_MASKS = buildFeatureMasks();
+
+constexpr uint32_t EVEN_ROWS = 0x0F0F0F0Fu;
+constexpr uint32_t ODD_ROWS  = 0xF0F0F0F0u;
+constexpr uint32_t COL_K0    = 0x11111111u;
+constexpr uint32_t COL_K3    = 0x88888888u;
+constexpr uint32_t ROW_0     = 0x0000000Fu;
+constexpr uint32_t ROW_7     = 0xF0000000u;
+
+struct ScalarLanes {
+    using V = uint32_t;
+    static constexpr size_t WIDTH = 1;
+
+    static V splat(uint32_t x) { return x; }
+    static V band(V a, V b) { return a & b; }
+    static V bor(V a, V b) { return a | b; }
+    static V andNot(V a, V b) { return ~a & b; }
+    template<int N> static V shl(V a) { return a << N; }
+    template<int N> static V shr(V a) { return a >> N; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V popcount(V a) { return static_cast<V>(std::popcount(a)); }
+    static V mul(V count, int weight) { return count * static_cast<V>(weight); }
+};
+
+#ifdef EVAL_HAS_SSE2
+struct Sse2Lanes {
+    using V = __m128i;
+    static constexpr size_t WIDTH = 4;
+
+    static V splat(uint32_t x) { return _mm_set1_epi32(static_cast<int>(x)); }
+    static V band(V a, V b) { return _mm_and_si128(a, b); }
+    static V bor(V a, V b) { return _mm_or_si128(a, b); }
+    static V andNot(V a, V b) { return _mm_andnot_si128(a, b); }
+    template<int N> static V shl(V a) { return _mm_slli_epi32(a, N); }
+    template<int N> static V shr(V a) { return _mm_srli_epi32(a, N); }
+    static V add(V a, V b) { return _mm_add_epi32(a, b); }
+    static V sub(V a, V b) { return _mm_sub_epi32(a, b); }
+    // Подсчёт битов в каждой 32-битной полосе (SWAR)
+    static V popcount(V x) {
+        x = _mm_sub_epi32(x, _mm_and_si128(_mm_srli_epi32(x, 1), splat(0x55555555u)));
+        x = _mm_add_epi32(_mm_and_si128(x, splat(0x33333333u)),
+            _mm_and_si128(_mm_srli_epi32(x, 2), splat(0x33333333u)));
+        x = _mm_and_si128(_mm_add_epi32(x, _mm_srli_epi32(x, 4)), splat(0x0F0F0F0Fu));
+        x = _mm_add_epi32(x, _mm_srli_epi32(x, 8));
+        x = _mm_add_epi32(x, _mm_srli_epi32(x, 16));
+        return _mm_and_si128(x, splat(0x3F));
+    }
+    // count <= 32 и weight < 2048: произведение помещается в младшие 16 бит полосы
+    static V mul(V count, int weight) {
+        return _mm_mullo_epi16(count, _mm_set1_epi32(weight));
+    }
+    static V load(const uint32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(int* p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+};
+#endif
+
+#ifdef EVAL_HAS_AVX2
+struct Avx2Lanes {
+    using V = __m256i;
+    static constexpr size_t WIDTH = 8;
+
+    static V splat(uint32_t x) { return _mm256_set1_epi32(static_cast<int>(x)); }
+    static V band(V a, V b) { return _mm256_and_si256(a, b); }
+    static V bor(V a, V b) { return _mm256_or_si256(a, b); }
+    static V andNot(V a, V b) { return _mm256_andnot_si256(a, b); }
+    template<int N> static V shl(V a) { return _mm256_slli_epi32(a, N); }
+    template<int N> static V shr(V a) { return _mm256_srli_epi32(a, N); }
+    static V add(V a, V b) { return _mm256_add_epi32(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_epi32(a, b); }
+    // Подсчёт битов по полубайтам через таблицу в регистре (vpshufb)
+    static V popcount(V x) {
+        const V table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const V low = _mm256_set1_epi8(0x0F);
+        V bytes = _mm256_add_epi8(_mm256_shuffle_epi8(table, _mm256_and_si256(x, low)),
+            _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(x, 4), low)));
+        // Сумма четырёх байтов полосы
+        bytes = _mm256_add_epi32(bytes, _mm256_srli_epi32(bytes, 8));
+        bytes = _mm256_add_epi32(bytes, _mm256_srli_epi32(bytes, 16));
+        return _mm256_and_si256(bytes, splat(0x3F));
+    }
+    static V mul(V count, int weight) { return _mm256_mullo_epi32(count, splat(static_cast<uint32_t>(weight))); }
+    static V load(const uint32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(int* p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+};
+#endif
+
+// Прибавить weight * count; знак веса известен при компиляции, ветвления по позиции нет
+template<class L>
+typename L::V addWeighted(typename L::V sum, typename L::V count, int weight) {
+    if (weight > 0) return L::add(sum, L::mul(count, weight));
+    if (weight < 0) return L::sub(sum, L::mul(count, -weight));
+    return sum;
+}
+
+// Сдвиг масок на одну клетку по направлению d (как shiftDir в checkers.cpp)
+template<class L, int D>
+typename L::V shiftLanes(typename L::V bb) {
+    if constexpr (D == 0) {
+        return L::bor(L::template shl<5>(L::band(bb, L::splat(EVEN_ROWS & ~COL_K3))),
+            L::template shl<4>(L::band(bb, L::splat(ODD_ROWS & ~ROW_7))));
+    }
+    else if constexpr (D == 1) {
+        return L::bor(L::template shl<4>(L::band(bb, L::splat(EVEN_ROWS))),
+            L::template shl<3>(L::band(bb, L::splat(ODD_ROWS & ~COL_K0 & ~ROW_7))));
+    }
+    else if constexpr (D == 2) {
+        return L::bor(L::template shr<3>(L::band(bb, L::splat(EVEN_ROWS & ~COL_K3 & ~ROW_0))),
+            L::template shr<4>(L::band(bb, L::splat(ODD_ROWS))));
+    }
+    else {
+        return L::bor(L::template shr<4>(L::band(bb, L::splat(EVEN_ROWS & ~ROW_0))),
+            L::template shr<5>(L::band(bb, L::splat(ODD_ROWS & ~COL_K0))));
+    }
+}
+
+// Клетки хода дамок по направлению D до первой занятой (7 шагов без ветвлений)
+template<class L, int D>
+typename L::V kingRay(typename L::V kings, typename L::V empty) {
+    typename L::V ray = L::band(shiftLanes<L, D>(kings), empty);
+    typename L::V reach = ray;
+    for (int step = 1; step < 7; ++step) {
+        ray = L::band(shiftLanes<L, D>(ray), empty);
+        reach = L::bor(reach, ray);
+    }
+    return reach;
+}
+
+// Число клеток, куда может пойти хотя бы одна дамка (по направлению — объединение лучей)
+template<class L>
+typename L::V kingReachCount(typename L::V kings, typename L::V empty) {
+    return L::add(
+        L::add(L::popcount(kingRay<L, 0>(kings, empty)), L::popcount(kingRay<L, 1>(kings, empty))),
+        L::add(L::popcount(kingRay<L, 2>(kings, empty)), L::popcount(kingRay<L, 3>(kings, empty))));
+}
+
+template<class L>
+typename L::V squareLanes(typename L::V white, typename L::V black, typename L::V kings) {
+    typename L::V wm = L::andNot(kings, white);
+    typename L::V wk = L::band(white, kings);
+    typename L::V bm = L::andNot(kings, black);
+    typename L::V bk = L::band(black, kings);
+    typename L::V sum = L::splat(0);
+    for (size_t i = 0; i < FEATURE_COUNT; ++i) {
+        const auto& f = Evaluation::FEATURES[i];
+        typename L::V wmask = L::splat(FEATURE_MASKS.white[i]);
+        typename L::V bmask = L::splat(FEATURE_MASKS.black[i]);
+        sum = addWeighted<L>(sum, L::popcount(L::band(wm, wmask)), f.man);
+        sum = addWeighted<L>(sum, L::popcount(L::band(wk, wmask)), f.king);
+        sum = addWeighted<L>(sum, L::popcount(L::band(bm, bmask)), -f.man);
+        sum = addWeighted<L>(sum, L::popcount(L::band(bk, bmask)), -f.king);
+    }
+    return sum;
+}
+
+template<class L>
+typename L::V mobilityLanes(typename L::V white, typename L::V black, typename L::V kings) {
+    typename L::V empty = L::andNot(L::bor(white, black), L::splat(0xFFFFFFFFu));
+    typename L::V wm = L::andNot(kings, white);
+    typename L::V wk = L::band(white, kings);
+    typename L::V bm = L::andNot(kings, black);
+    typename L::V bk = L::band(black, kings);
+
+    // Простые ходят вперёд: белые по направлениям 0 и 1, чёрные — 2 и 3
+    typename L::V whiteMen = L::add(L::popcount(L::band(shiftLanes<L, 0>(wm), empty)),
+        L::popcount(L::band(shiftLanes<L, 1>(wm), empty)));
+    typename L::V blackMen = L::add(L::popcount(L::band(shiftLanes<L, 2>(bm), empty)),
+        L::popcount(L::band(shiftLanes<L, 3>(bm), empty)));
+    typename L::V whiteKings = kingReachCount<L>(wk, empty);
+    typename L::V blackKings = kingReachCount<L>(bk, empty);
+
+    typename L::V sum = L::splat(0);
+    sum = addWeighted<L>(sum, whiteMen, Evaluation::MAN_MOBILITY);
+    sum = addWeighted<L>(sum, blackMen, -Evaluation::MAN_MOBILITY);
+    sum = addWeighted<L>(sum, whiteKings, Evaluation::KING_MOBILITY);
+    sum = addWeighted<L>(sum, blackKings, -Evaluation::KING_MOBILITY);
+    return sum;
+}
+
+template<class L>
+typename L::V evaluateLanes(typename L::V white, typename L::V black, typename L::V kings) {
+    return L::add(squareLanes<L>(white, black, kings), mobilityLanes<L>(white, black, kings));
+}
+
+// Пакетная оценка полными векторами; возвращает число оценённых позиций
+template<class L>
+size_t evaluateBatchLanes(const EvalPosition* positions, int* scores, size_t count) {
+    size_t done = 0;
+    for (; done + L::WIDTH <= count; done += L::WIDTH) {
+        alignas(32) uint32_t white[L::WIDTH], black[L::WIDTH], kings[L::WIDTH];
+        for (size_t j = 0; j < L::WIDTH; ++j) {
+            white[j] = positions[done + j].white;
+            black[j] = positions[done + j].black;
+            kings[j] = positions[done + j].kings;
+        }
+        L::store(scores + done, evaluateLanes<L>(L::load(white), L::load(black), L::load(kings)));
+    }
+    return done;
+}
+
+} // namespace
+
+#endif // EVAL_LANES_H
@@ -0,0 +1,126 @@
+﻿#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Позиция для пакетной оценки: битборды как в CheckersBoard (бит s — тёмная клетка s)
+struct EvalPosition {
+    uint32_t white = 0;
+    uint32_t black = 0;
+    uint32_t kings = 0;
+};
+
+// Вариант оценки для сравнения версий движка (программа match)
+enum class EvalVariant {
+    FULL,         // клеточная часть и подвижность
+    NO_MOBILITY   // только клеточная часть
+};
+
+// Оценочная функция (с точки зрения белых) из двух частей:
+//  - клеточная: материал, таблица клеток (темп — продвижение простых),
+//    охрана последнего ряда, центр, большая дорога и край для дамок.
+//    Сумма по шашкам, поэтому CheckersBoard ведёт её инкрементально;
+//  - подвижность: число свободных ходов простых и дамок, считается сдвигами масок.
+// Обе части считаются без ветвлений по позиции: веса признаков умножаются
+// на число шашек под маской. Пакетная оценка идёт по 8 (AVX2) или 4 (SSE2)
+// позиции за раз, иначе — скалярно; формула одна для всех путей.
+class Evaluation {
+public:
+    static constexpr int MAN_VALUE = 100;
+    static constexpr int KING_VALUE = 300;
+    static constexpr int MAN_MOBILITY = 2;   // за каждый свободный ход простой
+    static constexpr int KING_MOBILITY = 1;  // за каждую клетку, куда может пойти дамка
+
+    // Клеточный признак: вес простой и дамки на клетках маски (маска для белых,
+    // для чёрных — повёрнутая на 180°)
+    struct SquareFeature {
+        uint32_t mask;
+        int man;
+        int king;
+    };
+
+    static constexpr uint32_t ROW_0 = 0x0000000Fu;
+    static constexpr uint32_t ROW_1 = 0x000000F0u;
+    static constexpr uint32_t ROW_2 = 0x00000F00u;
+    static constexpr uint32_t ROW_3 = 0x0000F000u;
+    static constexpr uint32_t ROW_4 = 0x000F0000u;
+    static constexpr uint32_t ROW_5 = 0x00F00000u;
+    static constexpr uint32_t ROW_6 = 0x0F000000u;
+    static constexpr uint32_t CENTRE = 0x00666600u;         // C3..F6
+    static constexpr uint32_t LONG_DIAGONAL = 0x11224488u;  // H1..A8
+    static constexpr uint32_t EDGE = 0x18181818u;           // столбцы A и H
+
+    static constexpr SquareFeature FEATURES[] = {
+        { 0xFFFFFFFFu,   MAN_VALUE, KING_VALUE },  // материал
+        { ROW_0,         8,  0 },                  // охрана последнего ряда
+        { ROW_1,         2,  0 },                  // темп: продвижение простых
+        { ROW_2,         4,  0 },
+        { ROW_3,         6,  0 },
+        { ROW_4,         9,  0 },
+        { ROW_5,        12,  0 },
+        { ROW_6,        16,  0 },
+        { CENTRE,        4,  6 },                  // центр
+        { LONG_DIAGONAL, 0,  8 },                  // дамка на большой дороге
+        { EDGE,          0, -4 },                  // дамка на краю
+    };
+
+    // Поворот доски на 180°: клетка s переходит в 31 - s
+    static constexpr uint32_t rotate(uint32_t bb) {
+        uint32_t out = 0;
+        for (int s = 0; s < 32; ++s) {
+            if (bb & (1u << s)) out |= 1u << (31 - s);
+        }
+        return out;
+    }
+
+    // Клеточная оценка одной шашки: [W, B, DW, DB][клетка], со знаком
+    struct PieceSquareTable {
+        int16_t value[4][32];
+    };
+
+    static constexpr PieceSquareTable buildPieceSquareTable() {
+        PieceSquareTable t{};
+        for (const auto& f : FEATURES) {
+            uint32_t blackMask = rotate(f.mask);
+            for (int s = 0; s < 32; ++s) {
+                if (f.mask & (1u << s)) {
+                    t.value[0][s] = static_cast<int16_t>(t.value[0][s] + f.man);
+                    t.value[2][s] = static_cast<int16_t>(t.value[2][s] + f.king);
+                }
+                if (blackMask & (1u << s)) {
+                    t.value[1][s] = static_cast<int16_t>(t.value[1][s] - f.man);
+                    t.value[3][s] = static_cast<int16_t>(t.value[3][s] - f.king);
+                }
+            }
+        }
+        return t;
+    }
+
+    static const PieceSquareTable PIECE_SQUARE;
+
+    // Клеточная часть полным пересчётом по признакам (сверка инкрементальной суммы)
+    static int squareScore(uint32_t white, uint32_t black, uint32_t kings);
+    // Подвижность
+    static int mobilityScore(uint32_t white, uint32_t black, uint32_t kings);
+    // Полная оценка одной позиции
+    static int evaluate(uint32_t white, uint32_t black, uint32_t kings);
+
+    // Пакетная оценка: scores[i] = evaluate(positions[i])
+    static void evaluateBatch(const EvalPosition* positions, int* scores, size_t count);
+    // Набор инструкций пакетной оценки на этом процессоре: "AVX2", "SSE2" или "scalar"
+    static const char* instructionSet();
+
+private:
+    // AVX2 собран и поддерживается процессором (проверяется один раз)
+    static bool useAvx2();
+    // Реализация AVX2 в отдельной единице трансляции (собирается с -mavx2):
+    // ширина вектора (0 — AVX2 не собран) и число оценённых позиций (кратно 8)
+    static size_t avx2Width();
+    static size_t evaluateBatchAvx2(const EvalPosition* positions, int* scores, size_t count);
+};
+
+inline constexpr Evaluation::PieceSquareTable Evaluation::PIECE_SQUARE =
+    Evaluation::buildPieceSquareTable();
+
+#endif // EVALUATION_H
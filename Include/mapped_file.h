@@ -0,0 +1,36 @@
+﻿#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Файл, отображённый в память только для чтения (mmap / MapViewOfFile).
+// Отображение живёт, пока жив объект; указатель data() при перемещении не меняется.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // false — файла нет, он пуст или не отображается
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return base != nullptr; }
+    const uint8_t* data() const { return static_cast<const uint8_t*>(base); }
+    size_t size() const { return bytes; }
+
+private:
+    const void* base = nullptr;
+    size_t bytes = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,97 @@
+﻿#ifndef MCTS_H
+#define MCTS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "checkers.h"
+
+// Настройки поиска Монте-Карло
+struct MctsOptions {
+    // Выбор хода в дереве: PUCT (априорные вероятности ходов по оценочной
+    // функции) или UCT (без априорных вероятностей)
+    bool puct = true;
+    double exploration = 1.4;   // коэффициент исследования c
+    int virtualLoss = 3;        // виртуальных поражений на узел, пока его проходит поток
+    int rolloutPlies = 24;      // случайных полуходов розыгрыша до оценки позиции
+    uint64_t playouts = 0;      // предел розыгрышей за поиск; 0 — по времени или флагу остановки
+};
+
+// Поиск Монте-Карло по дереву (MCTS) — альтернатива альфа-бете для
+// CheckersBoard::search (см. setMonteCarloTree). Итерация: спуск по дереву
+// по UCT/PUCT, раскрытие листа, случайный розыгрыш с обязательной рубкой
+// (генератор ходов доски) и оценкой в конце, обратное распространение.
+//
+// Параллельность по дереву: все потоки идут по одному дереву. Счётчики
+// узлов атомарные, блокировок нет; проходящий узел поток добавляет ему
+// виртуальные поражения, чтобы остальные расходились по другим ветвям.
+// Раскрывает узел один поток, остальные в это время разыгрывают из него.
+//
+// Узлы берутся из заранее выделенной области подряд и не освобождаются
+// по одному. Между ходами область не перевыделяется: если новая позиция
+// есть в дереве прошлого поиска (на один-два полухода ниже корня),
+// поддерево сохраняется со всей статистикой, иначе область очищается.
+class MonteCarloTree {
+public:
+    explicit MonteCarloTree(size_t megabytes = 64);
+
+    MonteCarloTree(const MonteCarloTree&) = delete;
+    MonteCarloTree& operator=(const MonteCarloTree&) = delete;
+
+    // Размер задаётся при старте; дерево при этом теряется
+    void resize(size_t megabytes);
+    void clear();
+    size_t capacity() const { return nodeCount; }
+    // Узлов занято (с учётом сохранённых от прошлых поисков)
+    size_t used() const;
+
+    void setOptions(const MctsOptions& mctsOptions) { options = mctsOptions; }
+    const MctsOptions& searchOptions() const { return options; }
+
+    // Поиск для стороны хода доски. depth в limits не используется;
+    // без времени, предела розыгрышей и внешнего флага — DEFAULT_PLAYOUTS.
+    // В результате nodes — число розыгрышей, depth — наибольшая глубина дерева.
+    SearchResult search(const CheckersBoard& board, const SearchLimits& limits);
+
+    static const uint64_t DEFAULT_PLAYOUTS = 20000;
+
+private:
+    // Состояние узла: не раскрыт, раскрывается одним из потоков, раскрыт, конец партии
+    enum : uint8_t { NEW, EXPANDING, EXPANDED, TERMINAL };
+
+    // Награда — сумма результатов розыгрышей в тысячных долях очка
+    // для стороны, сделавшей ход move (победа 1000, ничья 500)
+    struct Node {
+        Move move;
+        std::atomic<uint32_t> visits{ 0 };
+        std::atomic<uint32_t> virtualLoss{ 0 };
+        std::atomic<uint64_t> reward{ 0 };
+        std::atomic<uint8_t> state{ NEW };
+        uint16_t childCount = 0;
+        uint32_t firstChild = 0;
+        float prior = 0.0f;
+    };
+
+    struct Worker;
+
+    std::unique_ptr<Node[]> nodes;
+    size_t nodeCount = 0;
+    std::atomic<size_t> next{ 0 };
+    uint32_t root = 0;
+    // Позиция корня: по ней находится новый корень при следующем поиске
+    uint32_t rootWhite = 0, rootBlack = 0, rootKings = 0;
+    bool rootWhiteToMove = true;
+    MctsOptions options;
+
+    void reset(const CheckersBoard& board);
+    bool reuseSubtree(const CheckersBoard& board);
+    void resetNode(Node& node, const Move& move);
+    bool expand(Node& node, CheckersBoard& board);
+    uint32_t selectChild(const Node& node) const;
+    void playout(Worker& worker);
+    double rollout(Worker& worker);
+    void principalVariation(bool whiteToMove, SearchResult& result) const;
+};
+
+#endif // MCTS_H
@@ -0,0 +1,51 @@
+﻿#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+
+// Запись книги: позиция (ключ Зобриста) -> ход и его вес.
+// Ход задан номером в списке getAllPossibleMoves, как и в таблице транспозиций;
+// клетки from/to проверяются при выборе, чтобы случайное совпадение ключа не дало чужой ход.
+struct BookEntry {
+    uint64_t key = 0;
+    uint16_t moveIndex = 0;
+    uint8_t from = 0;
+    uint8_t to = 0;
+    uint32_t weight = 0;
+};
+static_assert(sizeof(BookEntry) == 16, "BookEntry is stored in the file as is");
+
+// Дебютная книга: отсортированный по ключу массив записей в файле,
+// отображённом в память; поиск — двоичный. Только чтение, без блокировок.
+class OpeningBook {
+public:
+    OpeningBook() = default;
+
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    // false — файла нет или он повреждён; прежняя книга при этом закрывается
+    bool load(const std::string& path);
+    bool isLoaded() const { return count > 0; }
+    size_t size() const { return count; }
+
+    // Записи позиции подряд в [first, last); first == last — позиции в книге нет
+    void find(uint64_t key, const BookEntry*& first, const BookEntry*& last) const;
+
+    // Сортирует записи, складывает веса одинаковых ходов и пишет файл
+    static bool write(const std::string& path, std::vector<BookEntry> entries);
+
+    // Общая книга процесса (пустая, пока не вызван load)
+    static OpeningBook& shared();
+
+private:
+    MappedFile file;
+    const BookEntry* entries = nullptr;
+    size_t count = 0;
+};
+
+#endif // OPENING_BOOK_H
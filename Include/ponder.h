@@ -0,0 +1,51 @@
+﻿#ifndef PONDER_H
+#define PONDER_H
+
+#include <chrono>
+#include <future>
+#include <stop_token>
+#include <vector>
+#include "checkers.h"
+
+// Размышление в время соперника. Пока человек выбирает ход, в фоне идёт поиск
+// позиции после предсказанного ответа (второй ход главного варианта). Если ход
+// угадан, его поиск продолжается до конца бюджета и даёт ответ сразу; если нет,
+// фоновый поиск отменяется, а новый начинается с уже заполненной таблицей
+// транспозиций. Без предсказания в фоне ищется сама позиция соперника: таблица
+// прогревается для всех его ответов.
+class Ponder {
+public:
+    explicit Ponder(std::chrono::milliseconds budget) : budget(budget) {}
+    ~Ponder() { cancel(); }
+
+    Ponder(const Ponder&) = delete;
+    Ponder& operator=(const Ponder&) = delete;
+
+    // Начать размышление; board — позиция, в которой ходит соперник
+    void start(const CheckersBoard& board);
+    // Прервать фоновый поиск и дождаться его завершения
+    void cancel();
+
+    // Ход компьютера в позиции board: результат угаданного размышления,
+    // иначе ход из дебютной книги или поиск за бюджет времени
+    Move think(CheckersBoard& board);
+
+    // Последний ход компьютера взят из размышления
+    bool lastWasHit() const { return lastHit; }
+    int hits() const { return hitCount; }
+    int misses() const { return missCount; }
+
+private:
+    std::chrono::milliseconds budget;
+    std::stop_source stop;
+    std::future<SearchResult> pending;
+    uint64_t ponderKey = 0;                          // позиция фонового поиска
+    bool predicted = false;                          // в фоне ищется позиция после предсказанного ответа
+    std::chrono::steady_clock::time_point started;
+    std::vector<Move> lastPv;                        // главный вариант последнего хода компьютера
+    bool lastHit = false;
+    int hitCount = 0;
+    int missCount = 0;
+};
+
+#endif // PONDER_H
@@ -0,0 +1,100 @@
+﻿#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+
+// Результат позиции из таблицы окончаний для стороны хода
+enum class WDL : int8_t {
+    LOSS = -1,
+    DRAW = 0,
+    WIN = 1
+};
+
+struct TBEntry {
+    WDL wdl = WDL::DRAW;
+    int distance = 0;  // полуходов до смены материала (рубки или превращения)
+};
+
+// Состав одной таблицы. Ходят в таблице всегда «белые»: позиция с ходом
+// чёрных приводится к ней поворотом доски на 180° и сменой цвета.
+struct Material {
+    int whiteMen = 0;
+    int whiteKings = 0;
+    int blackMen = 0;
+    int blackKings = 0;
+
+    int pieces() const { return whiteMen + whiteKings + blackMen + blackKings; }
+    bool operator==(const Material& other) const {
+        return whiteMen == other.whiteMen && whiteKings == other.whiteKings &&
+            blackMen == other.blackMen && blackKings == other.blackKings;
+    }
+
+    // Индекс — номер расстановки по 32 тёмным клеткам: группы (белые простые,
+    // белые дамки, чёрные простые, чёрные дамки) нумеруются сочетаниями
+    // по клеткам, ещё не занятым предыдущими группами
+    uint64_t size() const;
+    uint64_t index(uint32_t white, uint32_t black, uint32_t kings) const;
+    void decode(uint64_t index, uint32_t& white, uint32_t& black, uint32_t& kings) const;
+
+    Material flipped() const { return { blackMen, blackKings, whiteMen, whiteKings }; }
+    // Имя файла: цифры whiteMen whiteKings blackMen blackKings, например "1201.ctb"
+    std::string fileName() const;
+    static Material of(uint32_t white, uint32_t black, uint32_t kings);
+};
+
+// Таблицы окончаний, отображённые в память только для чтения.
+// load() вызывается до поиска; probe() не блокирует и не пишет,
+// поэтому одни и те же таблицы читают все потоки поиска.
+class Tablebases {
+public:
+    static const int MAX_PIECES = 6;
+
+    Tablebases() = default;
+
+    Tablebases(const Tablebases&) = delete;
+    Tablebases& operator=(const Tablebases&) = delete;
+
+    // Отобразить все найденные в каталоге таблицы; возвращает их число
+    int load(const std::string& directory);
+    // Один файл таблицы; false — файла нет или он повреждён
+    bool add(const std::string& path);
+
+    // Наибольшее число шашек среди загруженных таблиц (0 — таблиц нет)
+    int maxPieces() const { return largest; }
+
+    // Наибольшее расстояние по таблицам всех составов, которые могут
+    // возникнуть из позиции рубками и превращениями (при любой стороне хода);
+    // 0 — таких таблиц нет. Расстояние, упёршееся в предел записи, — UNBOUNDED
+    static const int UNBOUNDED = 1 << 16;
+    int maxDistance(uint32_t white, uint32_t black, uint32_t kings) const;
+
+    // Позиция в битбордах CheckersBoard; false — таблицы для такого материала нет
+    bool probe(uint32_t white, uint32_t black, uint32_t kings, bool whiteToMove, TBEntry& out) const;
+
+    // Запись в файле: 1 байт на позицию (0 — ничья, 1..127 — выигрыш, 128..255 — проигрыш)
+    static uint8_t encode(const TBEntry& entry);
+    static TBEntry decodeByte(uint8_t value);
+
+    // Поворот доски на 180°: клетка s переходит в 31 - s
+    static uint32_t rotate(uint32_t bb);
+
+    // Запись файла таблицы: заголовок и по байту на индекс
+    static bool write(const std::string& path, const Material& material, const std::vector<uint8_t>& values);
+
+    // Общие таблицы процесса (пустые, пока не вызван load)
+    static Tablebases& shared();
+
+private:
+    static const int DIM = MAX_PIECES + 1;
+
+    std::vector<MappedFile> files;
+    const uint8_t* tables[DIM][DIM][DIM][DIM] = {};
+    int longest[DIM][DIM][DIM][DIM] = {};  // наибольшее расстояние в таблице
+    int largest = 0;
+};
+
+#endif // TABLEBASE_H
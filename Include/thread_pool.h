@@ -0,0 +1,94 @@
+﻿#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Постоянный пул потоков с кражей задач.
+// У каждого потока своя очередь: свои задачи берутся с конца (LIFO),
+// чужие крадутся с начала (FIFO). Потоки живут всё время работы процесса.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+    // Задача из потока пула кладётся в его же очередь, иначе — по кругу.
+    // owner — метка владельца (группы), по которой задачу можно найти в очередях
+    void submit(std::function<void()> task, const void* owner = nullptr);
+
+    // Выполнить одну ожидающую задачу в текущем потоке (для ожидающих).
+    // С меткой owner берутся только задачи этого владельца
+    bool runPendingTask(const void* owner = nullptr);
+
+    // Сколько потоков пула приходится на один из одновременных поисков
+    // (не меньше одного); считаются живые объекты Share
+    unsigned fairShare() const;
+
+    // Учёт одновременного поиска в пуле на время жизни объекта
+    class Share {
+    public:
+        explicit Share(ThreadPool& pool) : pool(pool) { pool.sharers.fetch_add(1); }
+        ~Share() { pool.sharers.fetch_sub(1); }
+        Share(const Share&) = delete;
+        Share& operator=(const Share&) = delete;
+
+    private:
+        ThreadPool& pool;
+    };
+
+    // Общий пул процесса на hardware_concurrency потоков
+    static ThreadPool& instance();
+
+private:
+    struct Task {
+        std::function<void()> run;
+        const void* owner = nullptr;
+    };
+
+    struct WorkQueue {
+        std::mutex m;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<size_t> pending{ 0 };
+    std::atomic<unsigned> nextQueue{ 0 };
+    std::atomic<unsigned> sharers{ 0 };
+    bool stopping = false;
+
+    bool takeTask(unsigned self, const void* owner, std::function<void()>& task);
+    void workerLoop(unsigned index);
+};
+
+// Группа задач в пуле. wait() не просто ждёт, а помогает выполнять задачи
+// своей группы, поэтому задачи могут сами ставить подзадачи без риска
+// взаимной блокировки. Чужие задачи wait() не берёт: иначе ожидание одной
+// группы затянулось бы на всё время чужой, возможно бесконечной, задачи.
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool) : pool(pool) {}
+    ~TaskGroup() { wait(); }
+
+    void run(std::function<void()> task);
+    void wait();
+
+private:
+    ThreadPool& pool;
+    std::atomic<int> unfinished{ 0 };
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,86 @@
+﻿#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Тип оценки, сохранённой в таблице
+enum class Bound : uint8_t {
+    NONE,
+    EXACT,  // точное значение
+    LOWER,  // значение >= score (отсечение по beta)
+    UPPER   // значение <= score (ни один ход не поднял alpha)
+};
+
+// Распакованная запись таблицы
+struct TTEntry {
+    int score = 0;
+    int depth = 0;
+    Bound bound = Bound::NONE;
+    int moveIndex = -1;  // номер лучшего хода в списке getAllPossibleMoves, -1 - нет
+};
+
+// Счётчики для подбора размера таблицы
+struct TTStats {
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+    uint64_t cutoffs = 0;     // поиск завершён по записи таблицы
+    uint64_t stores = 0;
+    uint64_t collisions = 0;  // запись вытеснила другую позицию
+};
+
+// Таблица транспозиций фиксированного размера, общая для всех потоков поиска.
+// Корзина из 4 записей занимает одну строку кэша. Блокировок нет: запись
+// хранит key ^ data и data, поэтому разорванная запись просто не проходит проверку.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes = 64);
+
+    // Размер задаётся при старте; содержимое при этом теряется
+    void resize(size_t megabytes);
+    void clear();
+    size_t sizeInBytes() const;
+
+    // Новое поколение: записи прошлых поисков вытесняются первыми
+    void newSearch();
+
+    bool probe(uint64_t key, TTEntry& out);
+    void store(uint64_t key, int score, int depth, Bound bound, int moveIndex);
+    void recordCutoff();
+
+    TTStats stats() const;
+    void resetStats();
+
+    // Общая таблица процесса
+    static TranspositionTable& shared();
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> keyXorData{ 0 };
+        std::atomic<uint64_t> data{ 0 };
+    };
+    struct alignas(64) Bucket {
+        Slot slots[4];
+    };
+    // Счётчики разнесены по потокам, чтобы не делить одну строку кэша
+    struct alignas(64) Counters {
+        std::atomic<uint64_t> probes{ 0 };
+        std::atomic<uint64_t> hits{ 0 };
+        std::atomic<uint64_t> cutoffs{ 0 };
+        std::atomic<uint64_t> stores{ 0 };
+        std::atomic<uint64_t> collisions{ 0 };
+    };
+    static const int COUNTER_SHARDS = 64;
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucketCount = 0;
+    std::atomic<uint8_t> generation{ 0 };
+    std::unique_ptr<Counters[]> counters;
+
+    Bucket& bucketFor(uint64_t key) const;
+    Counters& localCounters() const;
+};
+
+#endif // TRANSPOSITION_H
@@ -0,0 +1,122 @@
+﻿#include "../Include/checkers.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// alloctest: генерация ходов, ход/откат и поиск не выделяют память в куче.
+// Глобальный operator new считает выделения, пока поднят флаг измерения.
+//
+//   alloctest
+//
+// Проверяется обход дерева ходов (getAllPossibleMoves, makeMoveUnchecked,
+// unmakeMove) из начальной позиции и из окончания с дамками, и итерации
+// поиска на фиксированную глубину: измерение идёт от промежуточного итога
+// одной итерации до итога последней, то есть захватывает все узлы между ними.
+// Код возврата 0 — выделений не было; запускается из ctest.
+
+namespace {
+
+std::atomic<bool> counting{ false };
+std::atomic<uint64_t> allocations{ 0 };
+
+void* allocate(std::size_t size) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+uint64_t walk(CheckersBoard& board, int depth) {
+    if (depth == 0) {
+        return 1;
+    }
+    MoveList moves = board.getAllPossibleMoves(board.isWhiteToMove());
+    uint64_t leaves = 0;
+    for (const Move& mv : moves) {
+        Undo u = board.makeMoveUnchecked(mv);
+        leaves += walk(board, depth - 1);
+        board.unmakeMove(u);
+    }
+    return leaves;
+}
+
+bool checkWalk(const char* name, const std::string& position, int depth) {
+    CheckersBoard board;
+    if (!position.empty() && !board.parsePosition(position)) {
+        std::cout << name << ": некорректная позиция\n";
+        return false;
+    }
+    allocations = 0;
+    counting = true;
+    uint64_t leaves = walk(board, depth);
+    counting = false;
+    std::cout << name << ": листьев " << leaves << ", выделений " << allocations << "\n";
+    return allocations == 0;
+}
+
+bool checkSearch(int firstDepth, int lastDepth) {
+    TranspositionTable table(16);
+    CheckersBoard board;
+    board.setTranspositionTable(&table);
+    board.setOpeningBook(nullptr);
+
+    uint64_t nodesFrom = 0, nodesTo = 0;
+    SearchLimits limits;
+    limits.depth = lastDepth;
+    limits.threads = 1;
+    limits.progress = [&](const SearchProgress& progress) {
+        if (progress.depth == firstDepth) {
+            nodesFrom = progress.nodes;
+            allocations = 0;
+            counting = true;
+        }
+        else if (progress.depth == lastDepth) {
+            counting = false;
+            nodesTo = progress.nodes;
+        }
+    };
+    SearchResult result = board.search(limits);
+    counting = false;
+    std::cout << "поиск, итерации " << firstDepth + 1 << ".." << lastDepth
+        << ": узлов " << nodesTo - nodesFrom << ", выделений " << allocations << "\n";
+    return result.depth == lastDepth && nodesTo > nodesFrom && allocations == 0;
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+int main() {
+    setlocale(LC_ALL, "ru");
+
+    bool ok = checkWalk("начальная позиция", "", 7);
+    ok = checkWalk("дамки", "W W:B3,F3 B:A6,E6,G8 DW:B1,F1 DB:C8,H5", 4) && ok;
+    ok = checkSearch(6, 11) && ok;
+    std::cout << (ok ? "Выделений памяти нет\n" : "ОШИБКА: есть выделения памяти\n");
+    return ok ? 0 : 1;
+}
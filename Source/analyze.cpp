@@ -0,0 +1,228 @@
+﻿#include "../Include/checkers.h"
+#include "../Include/thread_pool.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+// analyze: анализ набора позиций на всех ядрах.
+//
+//   analyze [-d глубина] [-m мс] [-H МБ] [-o файл] файл_позиций
+//     -d  глубина поиска (по умолчанию 10)
+//     -m  время на позицию в миллисекундах (0 — только по глубине)
+//     -H  таблица транспозиций каждого рабочего потока (по умолчанию 16 МБ)
+//     -o  файл результатов (по умолчанию стандартный вывод); "-" вместо файла позиций — стандартный ввод
+//
+// Позиции — по одной в строке в записи CheckersBoard::parsePosition; пустые
+// строки и строки с # пропускаются. Результат — строка JSON на позицию в том же
+// порядке: {"line":N,"position":"...","best":"C3 D4","score":12,"depth":10,"nodes":123,"pv":"..."};
+// оценка с точки зрения белых. Позиции читаются потоком: в работе и в очереди
+// на вывод не больше WINDOW_PER_THREAD позиций на поток пула, поэтому память
+// не зависит от размера входа.
+
+namespace {
+
+const size_t WINDOW_PER_THREAD = 4;
+
+struct AnalyzeOptions {
+    int depth = 10;
+    std::chrono::milliseconds budget{ 0 };
+    size_t hashMb = 16;
+};
+
+// Строка JSON с экранированием кавычек, обратной косой и управляющих символов
+std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char ch : text) {
+        switch (ch) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(ch) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+                out += buf;
+            }
+            else {
+                out += ch;
+            }
+        }
+    }
+    return out + "\"";
+}
+
+// Доска и таблица транспозиций рабочего потока: одни на все его позиции
+struct Worker {
+    CheckersBoard board;
+    TranspositionTable table;
+
+    explicit Worker(size_t hashMb) : table(hashMb) {
+        board.setTranspositionTable(&table);
+        board.setOpeningBook(nullptr);
+    }
+};
+
+std::string analyzePosition(const std::string& text, size_t lineNumber, const AnalyzeOptions& options) {
+    thread_local std::unique_ptr<Worker> worker;
+    if (!worker) {
+        worker = std::make_unique<Worker>(options.hashMb);
+    }
+
+    std::ostringstream out;
+    out << "{\"line\":" << lineNumber << ",\"position\":" << jsonString(text);
+    if (!worker->board.parsePosition(text)) {
+        out << ",\"error\":\"invalid position\"}";
+        return out.str();
+    }
+    // Чистая таблица на каждую позицию: результат не зависит от порядка и соседей
+    worker->table.clear();
+
+    SearchLimits limits;
+    limits.depth = options.depth;
+    limits.budget = options.budget;
+    limits.threads = 1;
+    SearchResult result = worker->board.search(limits);
+    if (result.bestMove.size() == 0) {
+        out << ",\"best\":null,\"score\":null,\"depth\":0,\"nodes\":0}";
+        return out.str();
+    }
+
+    std::string pv;
+    for (const auto& mv : result.pv) {
+        if (!pv.empty()) {
+            pv += ", ";
+        }
+        pv += CheckersBoard::moveToString(mv);
+    }
+    out << ",\"best\":" << jsonString(CheckersBoard::moveToString(result.bestMove))
+        << ",\"score\":" << result.score
+        << ",\"depth\":" << result.depth
+        << ",\"nodes\":" << result.nodes
+        << ",\"pv\":" << jsonString(pv) << "}";
+    return out.str();
+}
+
+// Ячейка окна: результат позиции ждёт, пока не будут выведены все предыдущие
+struct Slot {
+    std::string json;
+    std::atomic<bool> ready{ false };
+};
+
+void printUsage() {
+    std::cout << "Использование: analyze [-d глубина] [-m мс] [-H МБ] [-o файл] файл_позиций\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    setlocale(LC_ALL, "ru");
+
+    AnalyzeOptions options;
+    std::string inputPath;
+    std::string outputPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-d" && i + 1 < argc) {
+            options.depth = std::atoi(argv[++i]);
+        }
+        else if (arg == "-m" && i + 1 < argc) {
+            options.budget = std::chrono::milliseconds(std::atol(argv[++i]));
+        }
+        else if (arg == "-H" && i + 1 < argc) {
+            options.hashMb = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        }
+        else if (inputPath.empty() && (arg == "-" || arg[0] != '-')) {
+            inputPath = arg;
+        }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (inputPath.empty() || options.depth < 1 || options.hashMb == 0) {
+        printUsage();
+        return 1;
+    }
+
+    std::ifstream inputFile;
+    if (inputPath != "-") {
+        inputFile.open(inputPath);
+        if (!inputFile) {
+            std::cout << "Не удалось открыть " << inputPath << "\n";
+            return 1;
+        }
+    }
+    std::istream& input = inputPath == "-" ? std::cin : inputFile;
+
+    std::ofstream outputFile;
+    if (!outputPath.empty()) {
+        outputFile.open(outputPath, std::ios::trunc);
+        if (!outputFile) {
+            std::cout << "Не удалось открыть " << outputPath << "\n";
+            return 1;
+        }
+    }
+    std::ostream& output = outputPath.empty() ? std::cout : outputFile;
+
+    // Общая таблица не нужна: у каждого рабочего потока своя
+    TranspositionTable::shared().resize(1);
+
+    ThreadPool& pool = ThreadPool::instance();
+    const size_t window = WINDOW_PER_THREAD * (pool.size() + 1);
+    std::unique_ptr<Slot[]> slots(new Slot[window]);
+    size_t submitted = 0;
+    size_t written = 0;
+
+    // Вывести готовый результат самой старой позиции; пока он не готов — помогать пулу
+    auto writeNext = [&]() {
+        Slot& slot = slots[written % window];
+        while (!slot.ready.load(std::memory_order_acquire)) {
+            if (!pool.runPendingTask()) {
+                std::this_thread::yield();
+            }
+        }
+        output << slot.json << "\n";
+        slot.json.clear();
+        slot.ready.store(false, std::memory_order_relaxed);
+        ++written;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    TaskGroup group(pool);
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(input, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (submitted - written == window) {
+            writeNext();
+        }
+        Slot& slot = slots[submitted % window];
+        group.run([&slot, &options, text = line, lineNumber]() {
+            slot.json = analyzePosition(text, lineNumber, options);
+            slot.ready.store(true, std::memory_order_release);
+        });
+        ++submitted;
+    }
+    while (written < submitted) {
+        writeNext();
+    }
+    group.wait();
+    output.flush();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Позиций: " << submitted << ", время: " << seconds << " с\n";
+    return 0;
+}
@@ -0,0 +1,324 @@
+﻿#include "../Include/checkers.h"
+#include "../Include/mcts.h"
+#include "../Include/thread_pool.h"
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <iomanip>
+#include <iterator>
+#include <memory>
+
+// bench: поиск на фиксированной глубине по встроенному набору позиций.
+// Сумма узлов и подпись набора меняются только при изменении поведения поиска,
+// время и узлы/с — при изменении скорости.
+//
+//   bench [-d глубина] [-H МБ] [-t потоки] [-s [макс. потоков]] [-w] [-e] [-m розыгрышей]
+//     -d  глубина поиска для каждой позиции (по умолчанию 11)
+//     -H  размер таблицы транспозиций (по умолчанию 16 МБ)
+//     -t  потоков поиска (по умолчанию 1; подпись детерминирована только для 1)
+//     -s  масштабирование: прогон на 1, 2, 4, ... потоках, ускорение и лишние узлы
+//     -w  полный перебор без выборочного поиска (SearchOptions::fullWidth)
+//     -e  скорость оценочной функции: скалярно и пакетно (SIMD) на позициях набора
+//     -m  поиск Монте-Карло с заданным числом розыгрышей на позицию вместо
+//         альфа-беты (-d не используется, -H — размер дерева, узлы — розыгрыши)
+
+namespace {
+
+const char* const BENCH_POSITIONS[] = {
+    // Начальная позиция
+    "W W:B1,D1,F1,H1,A2,C2,E2,G2,B3,D3,F3,H3 B:A6,C6,E6,G6,B7,D7,F7,H7,A8,C8,E8,G8 DW: DB:",
+    // Дебют, миттельшпиль, позиции с длинными рубками, окончания
+    "W W:B1,D1,F1,H1,C2,E2,G2,D3,F3,H3,A4,C4 B:D5,H5,A6,E6,G6,B7,D7,H7,A8,C8,E8,G8 DW: DB:",
+    "W W:B1,D1,F1,H1,C2,E2,G2,D3,H3,A4,E4 B:B3,H5,A6,E6,G6,B7,D7,H7,A8,C8,E8,G8 DW: DB:",
+    "W W:B1,D1,F1,H1,C2,E2,D3,F3,H3,A4,E4 B:B3,G4,A6,E6,G6,B7,D7,H7,A8,C8,E8,G8 DW: DB:",
+    "W W:D1,F1,H1,A2,C2,B3,D3,H3,A4,C4 B:F3,D5,F5,A6,D7,F7,H7,A8,C8,E8,G8 DW: DB:",
+    "W W:F1,H1,A2,E2 B:F5,B7,A8,E8,G8 DW: DB:",
+    "B W:D1,F1,H1,C2,G2,D3,F3,H3,D5 B:A4,H5,A6,C6,E6,D7,F7,H7,A8,G8 DW: DB:",
+    "W W:B1,D1,F1,H1,C2,E2,G2,B3,D3,H3,E4 B:F5,E6,G6,B7,H7,A8,C8,E8,G8 DW: DB:",
+    "B W:B3 B:H5,A6,B7,D7,H7,E8,G8 DW: DB:",
+    "B W:H1,E2,G2,H3,A4,G4 B:C2,F5,E6,B7,H7,A8,C8,E8,G8 DW: DB:",
+    "W W:D3,H5 B:C6,G6,F7,H7 DW:G4 DB:D1",
+    "B W:H1,A2,C2,E2,B3,C4,E4,D5 B:A4,G4,A6,C6,B7,D7,E8,G8 DW: DB:F1",
+    "B W:A2,C2,G2,F3 B:E6,B7,H7,A8 DW: DB:",
+    "B W:D1,F1,H1,A2,C2,E2,F3,H3,E4,A6,E6 B:H5,C6,B7,D7,H7,A8,C8,E8,G8 DW: DB:",
+    "W W:B1,D1,F1,G2,B3,F3,H3,G4,C6 B:H5,E6,G6,H7,A8 DW: DB:",
+    "B W:B1,D1,F1,H1,A2,E2,G2,B3,D3,H3,D5 B:A6,C6,B7,D7,A8,C8,E8,G8 DW: DB:",
+    "B W:B1,F3,C4,E4 B:E6,G6 DW: DB:",
+    "W W:H1,E2,G2,B3,D3,H3,G4 B:B5,D5,F5,D7,F7,H7,A8,E8,G8 DW: DB:",
+    "W W:D1,F1,H1,A2,C2,E2,G2,B3,F3,E4 B:H3,B5,A6,C6,E6,G6,H7,A8,C8,E8,G8 DW: DB:",
+    "W W:D1,F1,H1,A2,E2,G2,B3 B:B5,A6,C6,E6,G6,H7,A8,C8,E8,G8 DW: DB:B1",
+    "W W:F1,H1,A2,E2,G2,B3 B:B5,A6,C6,E6,G6,H7,A8,C8,E8,G8 DW: DB:F5",
+    "B W:G2,D3,F3,H3,E4,B5,H5 B:A6,C6,B7 DW:D5 DB:A4",
+    "B W:F1,H1,C2,G2,D3,H3,G4,H5,A6 B:E4,D7,F7,A8,C8,E8 DW: DB:",
+    "W W:F1,H1,A2,C2,E2,G2,B3,D3,H3,H5 B:A6,C6,E6,G6,B7,D7,F7,H7,A8,E8 DW: DB:",
+    "W W:F1,H1,A2,C2,E2,G2,D3,H3,A4,H5 B:B5,C6,E6,G6,B7,D7,F7,H7,A8,E8 DW: DB:",
+    "W W:F1,H1,A2,E2,G2,B3,D3,H3,A4,H5 B:B5,D5,C6,G6,B7,D7,F7,H7,A8,E8 DW: DB:",
+    "W W:H1,D3,F3,H3,E4,B7 B:A4,G6 DW:G8 DB:",
+    "B W:B1,B3,D3,F3,H5 B:A4,C6,G6,D7,F7,A8,C8,E8,G8 DW: DB:",
+    "W W:H1,A2,E2,G2,F3,H3 B:G4,C6,E6,G6,D7,A8,C8,E8 DW: DB:",
+    "B W:D1,F1,H1,A2,G2,B3,H3,A4,G4 B:E4,E6,H7,A8,G8 DW:E8 DB:",
+    "W W:F1,H1,A2,C2,G2,F3,G4,H7 B:B5,C6,E6,C8,E8,G8 DW: DB:",
+    "W W:H1,A2,C2,E2,G2,F3,G4,H7 B:A4,C6,E6,C8,E8,G8 DW: DB:",
+    "W W:H1,A2,C2,E2,G2,F3,H5,H7 B:A4,B5,E6,C8,E8,G8 DW: DB:",
+    "W W:H1,A2,E2,G2,F3,H5,H7 B:C2,B5,E6,C8,E8,G8 DW: DB:",
+    "W W:H1,E2,G2,F3,H5,H7 B:A4,B5,E6,C8,E8,G8 DW: DB:",
+    "W W:B1,H1,E2,G2,F3,H5 B:D7,F7,H7,A8,C8,E8,G8 DW: DB:D1",
+    "W W:F1,H1,C2,E2,G2,D3,H5 B:H3,F5,E6,F7,H7,A8,E8 DW: DB:",
+    "B W:F1,H1,G2,B3,F3,A4,C4 B:H3,C6,B7,F7,H7,A8,E8 DW: DB:",
+    "B W:B1,D1,H1,C2,E2,D3,H3,H5,A6 B:D5,F5,F7,C8,E8,G8 DW: DB:",
+    "B W:F1,H1,A2,C2,G2,H3,D5 B:A4,A6,G6,F7,H7,A8,E8,G8 DW: DB:",
+    "B W:F1,H1,A2,C2,E2,G2,G4,F5,A6 B:D7,F7,H7,A8,E8,G8 DW: DB:",
+    "B W:F1,H1,G2,B3,D3,F3,H3,E4,A6 B:H5,E6,D7,F7,H7,A8,G8 DW: DB:",
+    "W W:D1,A2,C2,E2,G2,D3,H3,C4,D5 B:F5,F7,H7,E8,G8 DW: DB:",
+    "B W:B1,H1,E2,F3,H3,G4 B:A2,A4,H5,B7,D7,H7,A8,G8 DW: DB:",
+    "B W:H1,A2,E2,G2,F3,H3,A4,G4,H5 B:D5,E6,G6,D7,F7,H7,A8,E8 DW:C8 DB:B1",
+    // Дамочные окончания
+    "W W: B: DW:A2,C2 DB:F7",
+    "W W: B:D5,F5 DW:C2 DB:G8",
+    "B W: B: DW:A2,E2 DB:H7,B7",
+    "W W:C2,E2 B:F7,D7 DW:A6 DB:H3",
+    "B W: B: DW:A2,G2,E6 DB:D7",
+    "W W: B:C4,E6,G4 DW:B1 DB:H7",
+};
+
+struct BenchRun {
+    uint64_t nodes = 0;
+    double seconds = 0.0;
+    uint64_t signature = 0;
+};
+
+// FNV-1a по числу узлов и лучшему ходу каждой позиции
+void mixSignature(uint64_t& sig, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        sig ^= (value >> (8 * i)) & 0xFF;
+        sig *= 0x100000001B3ull;
+    }
+}
+
+// tree — дерево поиска Монте-Карло или nullptr для альфа-беты
+BenchRun runBench(int depth, int threads, const SearchOptions& options, MonteCarloTree* tree, bool verbose) {
+    BenchRun run;
+    run.signature = 0xCBF29CE484222325ull;
+    TranspositionTable& tt = TranspositionTable::shared();
+
+    int index = 0;
+    for (const char* text : BENCH_POSITIONS) {
+        ++index;
+        CheckersBoard board;
+        board.setSearchOptions(options);
+        board.setMonteCarloTree(tree);
+        if (!board.parsePosition(text)) {
+            std::cout << "Некорректная позиция " << index << ": " << text << "\n";
+            std::exit(1);
+        }
+        // Каждая позиция с чистой таблицей, чтобы результат не зависел от порядка
+        tt.clear();
+        if (tree) {
+            tree->clear();
+        }
+
+        SearchLimits limits;
+        limits.depth = depth;
+        limits.threads = threads;
+        auto start = std::chrono::steady_clock::now();
+        SearchResult result = board.search(limits);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        run.nodes += result.nodes;
+        run.seconds += seconds;
+        mixSignature(run.signature, result.nodes);
+        mixSignature(run.signature, static_cast<uint64_t>(result.bestMove.fromSquare()) << 8 | result.bestMove.toSquare());
+
+        if (verbose) {
+            std::cout << std::setw(3) << index << "  "
+                << std::setw(12) << CheckersBoard::moveToString(result.bestMove)
+                << std::setw(7) << result.score
+                << std::setw(12) << result.nodes << "\n";
+        }
+    }
+    return run;
+}
+
+uint64_t nodesPerSecond(const BenchRun& run) {
+    return static_cast<uint64_t>(run.seconds > 0 ? run.nodes / run.seconds : 0);
+}
+
+// Позиции набора и все позиции на два полухода от них
+void collectEvalPositions(CheckersBoard& board, int depth, std::vector<EvalPosition>& out) {
+    out.push_back({ board.whitePieces(), board.blackPieces(), board.kingPieces() });
+    if (depth == 0) {
+        return;
+    }
+    for (const auto& mv : board.getAllPossibleMoves(board.isWhiteToMove())) {
+        Undo u = board.makeMoveUnchecked(mv);
+        collectEvalPositions(board, depth - 1, out);
+        board.unmakeMove(u);
+    }
+}
+
+// Скалярная и пакетная оценка должны совпадать; время — на позицию
+int runEvalBench() {
+    std::vector<EvalPosition> positions;
+    for (const char* text : BENCH_POSITIONS) {
+        CheckersBoard board;
+        board.parsePosition(text);
+        collectEvalPositions(board, 2, positions);
+    }
+    const int rounds = 200;
+    std::vector<int> scalar(positions.size());
+    std::vector<int> batch(positions.size());
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < positions.size(); ++i) {
+            scalar[i] = Evaluation::evaluate(positions[i].white, positions[i].black, positions[i].kings);
+        }
+    }
+    double scalarSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        Evaluation::evaluateBatch(positions.data(), batch.data(), positions.size());
+    }
+    double batchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        mismatches += scalar[i] != batch[i];
+    }
+    double evaluations = static_cast<double>(positions.size()) * rounds;
+    std::cout << "Позиций: " << positions.size() << "\n";
+    std::cout << "Скалярно: " << scalarSeconds * 1e9 / evaluations << " нс/позиция\n";
+    std::cout << "Пакетно (" << Evaluation::instructionSet() << "): "
+        << batchSeconds * 1e9 / evaluations << " нс/позиция\n";
+    std::cout << "Расхождений: " << mismatches << "\n";
+    return mismatches == 0 ? 0 : 1;
+}
+
+void printUsage() {
+    std::cout << "Использование: bench [-d глубина] [-H МБ] [-t потоки] [-s [макс. потоков]] [-w] [-e] [-m розыгрышей]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    setlocale(LC_ALL, "ru");
+
+    int depth = 11;
+    size_t hashMb = 16;
+    int threads = 1;
+    bool scaling = false;
+    int maxThreads = 0;
+    bool evalOnly = false;
+    uint64_t playouts = 0;
+    SearchOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-d" && i + 1 < argc) {
+            depth = std::atoi(argv[++i]);
+        }
+        else if (arg == "-H" && i + 1 < argc) {
+            hashMb = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-t" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        }
+        else if (arg == "-s") {
+            scaling = true;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                maxThreads = std::atoi(argv[++i]);
+            }
+        }
+        else if (arg == "-w") {
+            options = SearchOptions::fullWidth();
+        }
+        else if (arg == "-e") {
+            evalOnly = true;
+        }
+        else if (arg == "-m" && i + 1 < argc) {
+            playouts = std::strtoull(argv[++i], nullptr, 10);
+            if (playouts == 0) {
+                printUsage();
+                return 1;
+            }
+        }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (evalOnly) {
+        return runEvalBench();
+    }
+    if (depth < 1 || hashMb == 0) {
+        printUsage();
+        return 1;
+    }
+
+    TranspositionTable::shared().resize(hashMb);
+    ThreadPool& pool = ThreadPool::instance();
+    std::unique_ptr<MonteCarloTree> tree;
+    if (playouts > 0) {
+        tree = std::make_unique<MonteCarloTree>(hashMb);
+        MctsOptions mctsOptions;
+        mctsOptions.playouts = playouts;
+        tree->setOptions(mctsOptions);
+    }
+
+    if (!scaling) {
+        if (threads <= 0) {
+            threads = static_cast<int>(pool.size());
+        }
+        BenchRun run = runBench(depth, threads, options, tree.get(), true);
+        std::cout << "Позиций: " << std::size(BENCH_POSITIONS) << "\n";
+        if (tree) {
+            std::cout << "Розыгрышей на позицию: " << playouts << "\n";
+        }
+        else {
+            std::cout << "Глубина: " << depth << "\n";
+        }
+        std::cout << "Потоков: " << threads << "\n";
+        std::cout << "Узлов: " << run.nodes << "\n";
+        std::cout << "Время: " << run.seconds << " с\n";
+        std::cout << "Узлов/с: " << nodesPerSecond(run) << "\n";
+        std::cout << "Подпись: " << std::hex << run.signature << std::dec << "\n";
+        return 0;
+    }
+
+    // Ускорение — по времени на весь набор; лишние узлы — доля узлов сверх однопоточного прогона
+    if (maxThreads <= 0) {
+        maxThreads = static_cast<int>(pool.size());
+    }
+    if (tree) {
+        std::cout << "Розыгрышей на позицию: " << playouts << "\n";
+    }
+    else {
+        std::cout << "Глубина: " << depth << "\n";
+    }
+    std::cout << "Потоки       Время        Узлов      Узлов/с  Ускорение  Лишние узлы\n";
+    // 1, 2, 4, ... и последним — ровно максимальное число потоков
+    std::vector<int> counts;
+    for (int n = 1; n < maxThreads; n *= 2) {
+        counts.push_back(n);
+    }
+    counts.push_back(maxThreads);
+
+    BenchRun base;
+    for (int n : counts) {
+        BenchRun run = runBench(depth, n, options, tree.get(), false);
+        if (n == 1) {
+            base = run;
+        }
+        double speedup = run.seconds > 0 ? base.seconds / run.seconds : 0.0;
+        double overhead = base.nodes ? static_cast<double>(run.nodes) / base.nodes - 1.0 : 0.0;
+        std::cout << std::setw(6) << n
+            << std::setw(12) << std::fixed << std::setprecision(3) << run.seconds
+            << std::setw(13) << run.nodes
+            << std::setw(13) << nodesPerSecond(run)
+            << std::setw(11) << std::setprecision(2) << speedup
+            << std::setw(12) << std::setprecision(1) << overhead * 100.0 << "%\n";
+        std::cout.unsetf(std::ios::fixed);
+    }
+    return 0;
+}
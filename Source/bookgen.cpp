@@ -0,0 +1,209 @@
+﻿#include "../Include/checkers.h"
+#include "../Include/opening_book.h"
+#include "../Include/thread_pool.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+
+// bookgen: дебютная книга (ключ позиции -> ходы с весами).
+//
+//   bookgen [-o файл] [-g партий] [-p полуходов] [-d глубина] [-s зерно] [-i записи]
+//     -o  файл книги (по умолчанию book.bin)
+//     -g  партий самоигры (по умолчанию 100; 0 — только импорт)
+//     -p  сколько первых полуходов партии попадает в книгу (по умолчанию 12)
+//     -d  глубина поиска хода в самоигре (по умолчанию 8)
+//     -s  зерно случайных ходов самоигры
+//     -i  записи партий: по партии в строке, ходы через ';' в формате ввода ("C3 D4; F6 E5")
+//
+// В самоигре записываются только ходы, найденные поиском. Для разнообразия
+// вместо поиска с вероятностью 1/4 делается случайный ход, он в книгу не идёт.
+
+namespace {
+
+// Таблица транспозиций потока самоигры (МБ): у каждого потока своя
+const size_t GAME_HASH_MB = 16;
+
+BookEntry makeEntry(CheckersBoard& board, const MoveList& moves, size_t index) {
+    BookEntry e;
+    e.key = board.hash();
+    e.moveIndex = static_cast<uint16_t>(index);
+    e.from = static_cast<uint8_t>(moves[index].fromSquare());
+    e.to = static_cast<uint8_t>(moves[index].toSquare());
+    e.weight = 1;
+    return e;
+}
+
+// Партия зависит только от зерна: таблица транспозиций — своя у потока
+// и очищается перед партией, так что соседние партии на неё не влияют
+std::vector<BookEntry> selfPlayGame(int plies, int depth, uint64_t seed) {
+    thread_local std::unique_ptr<TranspositionTable> table;
+    if (!table) {
+        table = std::make_unique<TranspositionTable>(GAME_HASH_MB);
+    }
+    table->clear();
+
+    std::vector<BookEntry> entries;
+    std::mt19937_64 rng(seed);
+    CheckersBoard board;
+    board.setTranspositionTable(table.get());
+    board.setOpeningBook(nullptr);
+
+    for (int ply = 0; ply < plies; ++ply) {
+        MoveList moves = board.getAllPossibleMoves(board.isWhiteToMove());
+        if (moves.empty()) {
+            break;
+        }
+        size_t index = 0;
+        if (rng() % 4 == 0) {
+            index = rng() % moves.size();
+        }
+        else {
+            SearchLimits limits;
+            limits.depth = depth;
+            limits.threads = 1;
+            Move best = board.search(limits).bestMove;
+            while (!(moves[index] == best)) {
+                ++index;
+            }
+            entries.push_back(makeEntry(board, moves, index));
+        }
+        board.makeMoveUnchecked(moves[index]);
+    }
+    return entries;
+}
+
+// Импорт записей партий; партия с недопустимым ходом пропускается целиком.
+// Возвращает число принятых партий.
+int importGames(const std::string& path, int plies, std::vector<BookEntry>& entries) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cout << "Не удалось открыть " << path << "\n";
+        return 0;
+    }
+    int games = 0;
+    int lineNumber = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        CheckersBoard board;
+        std::vector<BookEntry> game;
+        bool ok = true;
+        int ply = 0;
+        size_t pos = 0;
+        while (ok && ply < plies && pos < line.size()) {
+            size_t semi = line.find(';', pos);
+            if (semi == std::string::npos) semi = line.size();
+            std::string text = line.substr(pos, semi - pos);
+            pos = semi + 1;
+            if (text.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+
+            Move move;
+            MoveList moves = board.getAllPossibleMoves(board.isWhiteToMove());
+            auto it = moves.end();
+            if (board.parseUserMove(text, move)) {
+                it = std::find(moves.begin(), moves.end(), move);
+            }
+            if (it == moves.end()) {
+                std::cout << "Строка " << lineNumber << ": недопустимый ход \"" << text << "\"\n";
+                ok = false;
+                break;
+            }
+            game.push_back(makeEntry(board, moves, it - moves.begin()));
+            board.makeMoveUnchecked(*it);
+            ++ply;
+        }
+        if (ok && ply > 0) {
+            entries.insert(entries.end(), game.begin(), game.end());
+            ++games;
+        }
+    }
+    return games;
+}
+
+void printUsage() {
+    std::cout << "Использование: bookgen [-o файл] [-g партий] [-p полуходов] [-d глубина] [-s зерно] [-i записи]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    setlocale(LC_ALL, "ru");
+
+    std::string output = "book.bin";
+    std::string records;
+    int games = 100;
+    int plies = 12;
+    int depth = 8;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        }
+        else if (arg == "-g" && i + 1 < argc) {
+            games = std::atoi(argv[++i]);
+        }
+        else if (arg == "-p" && i + 1 < argc) {
+            plies = std::atoi(argv[++i]);
+        }
+        else if (arg == "-d" && i + 1 < argc) {
+            depth = std::atoi(argv[++i]);
+        }
+        else if (arg == "-s" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-i" && i + 1 < argc) {
+            records = argv[++i];
+        }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (games < 0 || plies < 1 || depth < 1) {
+        printUsage();
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<BookEntry> entries;
+
+    if (!records.empty()) {
+        int imported = importGames(records, plies, entries);
+        std::cout << "Импортировано партий: " << imported << "\n";
+    }
+
+    // Партии самоигры независимы: по задаче пула на партию.
+    // Общая таблица не нужна: у каждого потока своя
+    TranspositionTable::shared().resize(1);
+    std::mutex entriesMutex;
+    {
+        TaskGroup group(ThreadPool::instance());
+        for (int g = 0; g < games; ++g) {
+            group.run([&, g]() {
+                std::vector<BookEntry> game = selfPlayGame(plies, depth, seed * 1000003 + g);
+                std::lock_guard<std::mutex> lock(entriesMutex);
+                entries.insert(entries.end(), game.begin(), game.end());
+            });
+        }
+        group.wait();
+    }
+
+    if (!OpeningBook::write(output, entries)) {
+        std::cout << "Не удалось записать " << output << "\n";
+        return 1;
+    }
+    OpeningBook book;
+    book.load(output);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Партий самоигры: " << games << "\n";
+    std::cout << "Записей в книге: " << book.size() << "\n";
+    std::cout << "Время: " << seconds << " с\n";
+    return 0;
+}
@@ -1,39 +1,198 @@
 ﻿#include "../Include/checkers.h"
 #include <algorithm>
+#include <bit>
+#include <cassert>
 #include <cctype>
 #include <limits>
+#include <mutex>
+#include <random>
+#include <sstream>
 #include <thread>
+#include "../Include/mcts.h"
+#include "../Include/thread_pool.h"
+
+// === Таблицы тёмных клеток ===
+//
+// Тёмная клетка (r,c) получает номер s = r * 4 + c / 2, поэтому
+// обход битов от младшего к старшему совпадает с обходом доски по строкам.
+namespace {
+
+// Направления: 0 = (+1,+1), 1 = (+1,-1), 2 = (-1,+1), 3 = (-1,-1)
+constexpr int DIR_R[4] = { 1, 1, -1, -1 };
+constexpr int DIR_C[4] = { 1, -1, 1, -1 };
+
+constexpr uint32_t EVEN_ROWS = 0x0F0F0F0Fu;  // строки 0,2,4,6
+constexpr uint32_t ODD_ROWS  = 0xF0F0F0F0u;  // строки 1,3,5,7
+constexpr uint32_t COL_K0    = 0x11111111u;  // s % 4 == 0
+constexpr uint32_t COL_K3    = 0x88888888u;  // s % 4 == 3
+constexpr uint32_t ROW_0     = 0x0000000Fu;
+constexpr uint32_t ROW_7     = 0xF0000000u;
+
+struct SquareTables {
+    int8_t neighbor[32][4];  // соседняя клетка по направлению или -1
+};
+
+constexpr SquareTables buildSquareTables() {
+    SquareTables t{};
+    for (int s = 0; s < 32; ++s) {
+        int r = s / 4;
+        int c = 2 * (s % 4) + ((r % 2 == 0) ? 1 : 0);
+        for (int d = 0; d < 4; ++d) {
+            int nr = r + DIR_R[d];
+            int nc = c + DIR_C[d];
+            bool inside = (nr >= 0 && nr < 8 && nc >= 0 && nc < 8);
+            t.neighbor[s][d] = inside ? static_cast<int8_t>(nr * 4 + nc / 2) : -1;
+        }
+    }
+    return t;
+}
+
+constexpr SquareTables SQ = buildSquareTables();
+
+// Лучи дамки: для клетки s и направления d — клетки диагонали от s до края
+// по порядку удаления и их маска (без самой s). Направления 0 и 1 ведут
+// к старшим номерам клеток, 2 и 3 — к младшим, поэтому ближайшая занятая
+// клетка луча — младший или старший бит пересечения с occupied.
+struct RayTables {
+    uint32_t mask[32][4];
+    int8_t square[32][4][7];
+};
+
+constexpr RayTables buildRayTables() {
+    RayTables t{};
+    for (int s = 0; s < 32; ++s) {
+        for (int d = 0; d < 4; ++d) {
+            int n = 0;
+            for (int sq = SQ.neighbor[s][d]; sq >= 0; sq = SQ.neighbor[sq][d]) {
+                t.mask[s][d] |= 1u << sq;
+                t.square[s][d][n++] = static_cast<int8_t>(sq);
+            }
+            for (; n < 7; ++n) {
+                t.square[s][d][n] = -1;
+            }
+        }
+    }
+    return t;
+}
+
+constexpr RayTables RAYS = buildRayTables();
+
+// Ближайшая к началу луча клетка из непустой маски bb, лежащей на луче направления d
+inline int nearestOnRay(uint32_t bb, int d) {
+    return d < 2 ? std::countr_zero(bb) : 31 - std::countl_zero(bb);
+}
+
+// Первая занятая клетка луча из s по направлению d или -1.
+// free — число пустых клеток до неё (они идут первыми в RAYS.square[s][d])
+inline int firstBlocker(int s, int d, uint32_t occupied, int& free) {
+    uint32_t ray = RAYS.mask[s][d];
+    uint32_t hits = ray & occupied;
+    if (!hits) {
+        free = std::popcount(ray);
+        return -1;
+    }
+    int b = nearestOnRay(hits, d);
+    free = std::popcount(ray & ~RAYS.mask[b][d]) - 1;
+    return b;
+}
+
+// Ключи Зобриста: [тип шашки - 1][клетка] и ключ стороны хода.
+// Генерируются splitmix64 на этапе компиляции, поэтому одинаковы между запусками.
+struct ZobristKeys {
+    uint64_t piece[4][32];
+    uint64_t side;
+};
+
+constexpr uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys buildZobristKeys() {
+    ZobristKeys z{};
+    uint64_t state = 0x5EED5EED2025ull;
+    for (int p = 0; p < 4; ++p) {
+        for (int s = 0; s < 32; ++s) {
+            z.piece[p][s] = splitmix64(state);
+        }
+    }
+    z.side = splitmix64(state);
+    return z;
+}
+
+constexpr ZobristKeys ZOBRIST = buildZobristKeys();
+
+inline uint64_t pieceKey(Piece p, int s) {
+    return ZOBRIST.piece[static_cast<int>(p) - 1][s];
+}
+
+// Клеточная оценка шашки: [тип шашки - 1][клетка], со знаком (белые +, чёрные -).
+// Материал и позиционные признаки в одной таблице (см. Evaluation),
+// чтобы makeMoveUnchecked правил сумму только по изменившимся клеткам.
+inline int pieceValue(Piece p, int s) {
+    return Evaluation::PIECE_SQUARE.value[static_cast<int>(p) - 1][s];
+}
+
+// Сдвиг всех шашек маски на одну клетку по направлению d
+inline uint32_t shiftDir(uint32_t bb, int d) {
+    switch (d) {
+    case 0:  return ((bb & EVEN_ROWS & ~COL_K3) << 5) | ((bb & ODD_ROWS & ~ROW_7) << 4);
+    case 1:  return ((bb & EVEN_ROWS) << 4) | ((bb & ODD_ROWS & ~COL_K0 & ~ROW_7) << 3);
+    case 2:  return ((bb & EVEN_ROWS & ~COL_K3 & ~ROW_0) >> 3) | ((bb & ODD_ROWS) >> 4);
+    default: return ((bb & EVEN_ROWS & ~ROW_0) >> 4) | ((bb & ODD_ROWS & ~COL_K0) >> 5);
+    }
+}
+
+// Номер младшего установленного бита
+inline int lowestSquare(uint32_t bb) {
+    return std::countr_zero(bb);
+}
+
+// Есть ли у простых шашек men хотя бы одна рубка (через соседа в пустую клетку)
+inline bool menCanCapture(uint32_t men, uint32_t enemy, uint32_t empty) {
+    for (int d = 0; d < 4; ++d) {
+        if (shiftDir(shiftDir(men, d) & enemy, d) & empty) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+// Перенос списка в кучу с удвоением ёмкости
+void MoveList::grow() {
+    size_t bigger = capacity * 2;
+    std::unique_ptr<Move[]> moved(new Move[bigger]);
+    std::copy(data, data + count, moved.get());
+    spill = std::move(moved);
+    data = spill.get();
+    capacity = bigger;
+}
 
 // Конструктор
 CheckersBoard::CheckersBoard() {
-    board.resize(BOARD_SIZE, std::vector<Piece>(BOARD_SIZE, Piece::EMPTY));
-    initBoard();
+    tt = &TranspositionTable::shared();
+    tb = &Tablebases::shared();
+    book = &OpeningBook::shared();
+    mcts = nullptr;
+    evalVariant = EvalVariant::FULL;
+    statsOutput = nullptr;
     whiteToMove = true;
+    initBoard();
 }
 
 // Инициализация стандартной расстановки
 void CheckersBoard::initBoard() {
-    for (int r = 0; r < BOARD_SIZE; ++r) {
-        for (int c = 0; c < BOARD_SIZE; ++c) {
-            board[r][c] = Piece::EMPTY;
-        }
-    }
     // Белые (W) на верхних трёх рядах (r=0..2), чёрные (B) - на нижних (r=5..7)
-    // Только на тёмных клетках ((r+c)%2 == 1).
-    for (int r = 0; r < 3; ++r) {
-        for (int c = 0; c < BOARD_SIZE; ++c) {
-            if ((r + c) % 2 == 1) {
-                board[r][c] = Piece::W;
-            }
-        }
-    }
-    for (int r = 5; r < 8; ++r) {
-        for (int c = 0; c < BOARD_SIZE; ++c) {
-            if ((r + c) % 2 == 1) {
-                board[r][c] = Piece::B;
-            }
-        }
-    }
+    // Только на тёмных клетках ((r+c)%2 == 1): это ровно клетки 0..11 и 20..31.
+    whiteBB = 0x00000FFFu;
+    blackBB = 0xFFF00000u;
+    kingsBB = 0;
+    hashKey = computeHash();
+    evalScore = computeEvaluation();
 }
 
 // Отладочный вывод одной шашки
@@ -54,389 +213,974 @@ void CheckersBoard::printBoard() {
     for (int r = 0; r < BOARD_SIZE; ++r) {
         std::cout << (r + 1) << " |";
         for (int c = 0; c < BOARD_SIZE; ++c) {
-            std::cout << pieceToString(board[r][c]) << " ";
+            std::cout << pieceToString(pieceAt(r, c)) << " ";
         }
         std::cout << "\n";
     }
     std::cout << std::endl;
 }
 
+// Шашка на клетке (r,c); светлые клетки всегда пусты
+Piece CheckersBoard::pieceAt(int r, int c) const {
+    int s = squareIndex(r, c);
+    if (s < 0) return Piece::EMPTY;
+    uint32_t bit = 1u << s;
+    bool king = (kingsBB & bit) != 0;
+    if (whiteBB & bit) return king ? Piece::DW : Piece::W;
+    if (blackBB & bit) return king ? Piece::DB : Piece::B;
+    return Piece::EMPTY;
+}
+
 bool CheckersBoard::isWhiteToMove() const {
     return whiteToMove;
 }
 
 void CheckersBoard::setWhiteToMove(bool w) {
+    if (whiteToMove != w) {
+        hashKey ^= ZOBRIST.side;
+    }
     whiteToMove = w;
 }
 
+void CheckersBoard::setPosition(uint32_t white, uint32_t black, uint32_t kings, bool whiteMoves) {
+    assert(std::popcount(white) <= MAX_SIDE_PIECES && std::popcount(black) <= MAX_SIDE_PIECES);
+    whiteBB = white;
+    blackBB = black;
+    kingsBB = kings;
+    whiteToMove = whiteMoves;
+    hashKey = computeHash();
+    evalScore = computeEvaluation();
+}
+
+// Полный пересчёт ключа Зобриста (при расстановке и для проверки)
+uint64_t CheckersBoard::computeHash() const {
+    uint64_t key = whiteToMove ? ZOBRIST.side : 0;
+    for (uint32_t bb = occupiedBB(); bb; bb &= bb - 1) {
+        int s = lowestSquare(bb);
+        Coord c = squareCoord(s);
+        key ^= pieceKey(pieceAt(c.r, c.c), s);
+    }
+    return key;
+}
+
 // Проверяем, может ли текущий игрок сделать ход
 bool CheckersBoard::canCurrentPlayerMove() {
     auto moves = getAllPossibleMoves(whiteToMove);
     return !moves.empty();
 }
 
+MoveList CheckersBoard::getAllPossibleMoves(bool whiteSide) {
+    return whiteSide ? generateMoves<true>() : generateMoves<false>();
+}
+
 // Сбор всех ходов: сперва рубки, если есть — только они, иначе обычные
-std::vector<Move> CheckersBoard::getAllPossibleMoves(bool whiteSide) {
-    std::vector<Move> captureMoves;
-    std::vector<Move> normalMoves;
+template<bool White>
+MoveList CheckersBoard::generateMoves() {
+    MoveList moves;
+    uint32_t own = White ? whiteBB : blackBB;
 
-    for (int r = 0; r < BOARD_SIZE; ++r) {
-        for (int c = 0; c < BOARD_SIZE; ++c) {
-            Piece p = board[r][c];
-            if (!isColor(p, whiteSide)) continue;
+    // Принудительная рубка
+    if (hasCaptureFor<White>()) {
+        for (uint32_t bb = own; bb; bb &= bb - 1) {
+            getAllCapturesForPiece<White>(lowestSquare(bb), moves);
+        }
+        return moves;
+    }
+
+    for (uint32_t bb = own; bb; bb &= bb - 1) {
+        getAllNormalMovesForPiece<White>(lowestSquare(bb), moves);
+    }
+    return moves;
+}
+
+bool CheckersBoard::hasCapture(bool whiteSide) const {
+    return whiteSide ? hasCaptureFor<true>() : hasCaptureFor<false>();
+}
 
-            // Смотрим, есть ли рубки
-            std::vector<Move> pieceCaptures;
-            getAllCapturesForPiece(r, c, pieceCaptures);
-            if (!pieceCaptures.empty()) {
-                captureMoves.insert(captureMoves.end(),
-                    pieceCaptures.begin(),
-                    pieceCaptures.end());
+// Есть ли у стороны хотя бы одна рубка. Простые проверяются сдвигами
+// сразу все, дамки — поштучно по первой занятой клетке каждого луча.
+template<bool White>
+bool CheckersBoard::hasCaptureFor() const {
+    uint32_t own = White ? whiteBB : blackBB;
+    uint32_t enemy = White ? blackBB : whiteBB;
+    uint32_t occupied = occupiedBB();
+    if (menCanCapture(own & ~kingsBB, enemy, ~occupied)) {
+        return true;
+    }
+    for (uint32_t bb = own & kingsBB; bb; bb &= bb - 1) {
+        int s = lowestSquare(bb);
+        for (int d = 0; d < 4; ++d) {
+            uint32_t hits = RAYS.mask[s][d] & occupied;
+            if (!hits) {
+                continue;
             }
-            else {
-                // Если нет рубок, смотрим обычные ходы
-                std::vector<Move> pieceNormals;
-                getAllNormalMovesForPiece(r, c, pieceNormals);
-                normalMoves.insert(normalMoves.end(),
-                    pieceNormals.begin(),
-                    pieceNormals.end());
+            int sq = nearestOnRay(hits, d);
+            int land = SQ.neighbor[sq][d];
+            if ((enemy & (1u << sq)) && land >= 0 && !(occupied & (1u << land))) {
+                return true;
             }
         }
     }
-
-    // Принудительная рубка
-    if (!captureMoves.empty()) {
-        return captureMoves;
-    }
-    return normalMoves;
+    return false;
 }
 
-// makeMove: применяем путь из Move
+// makeMove: проверенный вход для ходов пользователя.
+// Ход применяется, только если он есть среди разрешённых в позиции.
 bool CheckersBoard::makeMove(const Move& move) {
-    if (move.path.size() < 2) {
+    if (move.size() < 2) {
         return false;
     }
+    auto moves = getAllPossibleMoves(whiteToMove);
+    for (const auto& mv : moves) {
+        if (mv == move) {
+            makeMoveUnchecked(mv);
+            return true;
+        }
+    }
+    return false;
+}
 
-    auto backupBoard = board;
-    bool savedWhiteToMove = whiteToMove;
+Undo CheckersBoard::makeMoveUnchecked(const Move& move) {
+    return whiteToMove ? makeMoveFor<true>(move) : makeMoveFor<false>(move);
+}
 
-    Coord start = move.from();
-    if (!isValidPos(start.r, start.c)) {
-        return false;
+// Быстрый путь для ходов из генератора: без проверок, с записью отката
+template<bool White>
+Undo CheckersBoard::makeMoveFor(const Move& move) {
+    uint32_t& own = White ? whiteBB : blackBB;
+    uint32_t& enemy = White ? blackBB : whiteBB;
+
+    Undo u;
+    u.key = hashKey;
+    u.eval = evalScore;
+    u.from = static_cast<int8_t>(move.fromSquare());
+    u.to = static_cast<int8_t>(move.toSquare());
+    u.captured = move.captured;
+    u.capturedKings = u.captured & kingsBB;
+    enemy &= ~u.captured;
+    kingsBB &= ~u.captured;
+
+    constexpr Piece enemyMan = White ? Piece::B : Piece::W;
+    constexpr Piece enemyKing = White ? Piece::DB : Piece::DW;
+    for (uint32_t bb = u.captured; bb; bb &= bb - 1) {
+        int s = lowestSquare(bb);
+        Piece victim = (u.capturedKings & (1u << s)) ? enemyKing : enemyMan;
+        hashKey ^= pieceKey(victim, s);
+        evalScore -= pieceValue(victim, s);
     }
-    Piece startP = board[start.r][start.c];
-    if (startP == Piece::EMPTY || !isColor(startP, whiteToMove)) {
-        return false;
+
+    uint32_t fromBit = 1u << u.from;
+    uint32_t toBit = 1u << u.to;
+    bool isKing = (kingsBB & fromBit) != 0;
+    constexpr Piece man = White ? Piece::W : Piece::B;
+    constexpr Piece king = White ? Piece::DW : Piece::DB;
+
+    // Порядок важен: дамка может вернуться на исходную клетку
+    own = (own & ~fromBit) | toBit;
+    if (isKing) {
+        kingsBB = (kingsBB & ~fromBit) | toBit;
     }
 
-    Piece curP = startP;
-    board[start.r][start.c] = Piece::EMPTY;
+    // Превращение в дамку на последнем для стороны ряду
+    constexpr uint32_t PROMOTION_ROW = White ? ROW_7 : ROW_0;
+    u.promoted = !isKing && (toBit & PROMOTION_ROW);
+    if (u.promoted) {
+        kingsBB |= toBit;
+    }
 
-    for (size_t i = 0; i < move.path.size() - 1; ++i) {
-        Coord c0 = move.path[i];
-        Coord c1 = move.path[i + 1];
+    Piece moved = isKing ? king : man;
+    Piece landed = (isKing || u.promoted) ? king : man;
+    hashKey ^= pieceKey(moved, u.from) ^ pieceKey(landed, u.to) ^ ZOBRIST.side;
+    evalScore += pieceValue(landed, u.to) - pieceValue(moved, u.from);
+    whiteToMove = !White;
+    return u;
+}
 
-        if (!isValidPos(c1.r, c1.c)) {
-            board = backupBoard;
-            whiteToMove = savedWhiteToMove;
-            return false;
+// После хода ходит соперник: откатываем за сторону, сделавшую ход
+void CheckersBoard::unmakeMove(const Undo& u) {
+    if (whiteToMove) {
+        unmakeMoveFor<false>(u);
+    }
+    else {
+        unmakeMoveFor<true>(u);
+    }
+}
+
+// Откат хода стороны White, сделанного makeMoveUnchecked
+template<bool White>
+void CheckersBoard::unmakeMoveFor(const Undo& u) {
+    whiteToMove = White;
+    uint32_t& own = White ? whiteBB : blackBB;
+    uint32_t& enemy = White ? blackBB : whiteBB;
+
+    uint32_t fromBit = 1u << u.from;
+    uint32_t toBit = 1u << u.to;
+    bool wasKing = (kingsBB & toBit) && !u.promoted;
+
+    own &= ~toBit;
+    kingsBB &= ~toBit;
+    own |= fromBit;
+    if (wasKing) {
+        kingsBB |= fromBit;
+    }
+
+    enemy |= u.captured;
+    kingsBB |= u.capturedKings;
+    hashKey = u.key;
+    evalScore = u.eval;
+}
+
+// Оценка позиции: готовая клеточная сумма плюс подвижность по маскам.
+// В отладочной сборке сумма сверяется с полным пересчётом по признакам,
+// чтобы инкрементальное обновление не разошлось с ним.
+int CheckersBoard::evaluateBoard() const {
+    assert(evalScore == computeEvaluation());
+    if (evalVariant == EvalVariant::NO_MOBILITY) {
+        return evalScore;
+    }
+    return evalScore + Evaluation::mobilityScore(whiteBB, blackBB, kingsBB);
+}
+
+int CheckersBoard::computeEvaluation() const {
+    return Evaluation::squareScore(whiteBB, blackBB, kingsBB);
+}
+
+// === Поиск ===
+
+namespace {
+
+// Выигрыш/проигрыш: WIN_SCORE - ply, чтобы короткий выигрыш был лучше длинного
+const int WIN_SCORE = 9999;
+const int WIN_THRESHOLD = WIN_SCORE - 1000;
+// Выигрыш по таблицам окончаний: ниже любого выигрыша, найденного перебором
+// (WIN_SCORE - ply), но выше WIN_THRESHOLD и при ply + distance до 255
+const int TB_WIN_SCORE = WIN_SCORE - 300;
+// Граница окна поиска: больше любой оценки
+const int INFINITE_SCORE = WIN_SCORE + 1;
+
+// Окно стремления в корне (в единицах оценки, простая = 100) и глубина, с которой оно включается
+const int ASPIRATION_WINDOW = 25;
+const int ASPIRATION_MIN_DEPTH = 4;
+
+// В таблице оценки выигрыша хранятся относительно узла, а не корня
+int scoreToTT(int score, int ply) {
+    if (score >= WIN_THRESHOLD) return score + ply;
+    if (score <= -WIN_THRESHOLD) return score - ply;
+    return score;
+}
+
+int scoreFromTT(int score, int ply) {
+    if (score >= WIN_THRESHOLD) return score - ply;
+    if (score <= -WIN_THRESHOLD) return score + ply;
+    return score;
+}
+
+} // namespace
+
+// Проверка остановки: флаг выставлен или (раз в 256 узлов) вышло время
+bool CheckersBoard::searchAborted() {
+    if (!control) {
+        return false;
+    }
+    if ((++searchNodes & 255) == 0) {
+        bool external = control->externalStop && control->externalStop->load(std::memory_order_relaxed);
+        if (external || (control->timeLimited && std::chrono::steady_clock::now() >= control->deadline)) {
+            control->stop->store(true, std::memory_order_relaxed);
         }
-        if (board[c1.r][c1.c] != Piece::EMPTY) {
-            board = backupBoard;
-            whiteToMove = savedWhiteToMove;
-            return false;
+    }
+    return control->stop->load(std::memory_order_relaxed);
+}
+
+// Внешний интерфейс — оценка с точки зрения белых; внутри negamax от стороны хода
+int CheckersBoard::minimax(int depth, int alpha, int beta, bool maximizingPlayer)
+{
+    bool savedSide = whiteToMove;
+    setWhiteToMove(maximizingPlayer);
+    alpha = std::clamp(alpha, -INFINITE_SCORE, INFINITE_SCORE);
+    beta = std::clamp(beta, -INFINITE_SCORE, INFINITE_SCORE);
+    int score = maximizingPlayer ? negamax<true>(depth, alpha, beta, 0)
+        : -negamax<false>(depth, -beta, -alpha, 0);
+    setWhiteToMove(savedSide);
+    return score;
+}
+
+// Negamax с альфа-бета и поиском главного варианта (PVS): оценка с точки
+// зрения стороны хода. Первый ход узла ищется с полным окном, остальные —
+// с нулевым (alpha, alpha + 1); если такой ход всё же лучше alpha,
+// он перепроверяется с полным окном.
+// Поиск идёт на одной изменяемой доске: makeMoveUnchecked / unmakeMove.
+// Параллельность — в search(): потоки делят только таблицу транспозиций.
+// При остановке по времени возвращается 0, и результат не записывается в таблицу.
+template<bool White>
+int CheckersBoard::negamax(int depth, int alpha, int beta, int ply)
+{
+    assert(whiteToMove == White);
+    if (searchAborted()) {
+        return 0;
+    }
+    int tbScore = 0;
+    if (ply > 0 && probeTablebases(ply, tbScore)) {
+        return White ? tbScore : -tbScore;
+    }
+    if (depth == 0) {
+        return quiescence<White>(alpha, beta, ply);
+    }
+
+    // Таблица транспозиций: оценки хранятся с точки зрения стороны хода
+    TTEntry entry;
+    int hashMove = -1;
+    bool ttHit = tt->probe(hashKey, entry);
+    if (control) {
+        control->stats.ttProbes++;
+        control->stats.ttHits += ttHit;
+    }
+    if (ttHit) {
+        hashMove = entry.moveIndex;
+        int score = scoreFromTT(entry.score, ply);
+        if (entry.depth >= depth) {
+            if (entry.bound == Bound::EXACT) {
+                tt->recordCutoff();
+                return score;
+            }
+            if (entry.bound == Bound::LOWER) {
+                alpha = std::max(alpha, score);
+            }
+            else if (entry.bound == Bound::UPPER) {
+                beta = std::min(beta, score);
+            }
+            if (beta <= alpha) {
+                tt->recordCutoff();
+                return score;
+            }
         }
+    }
+    // Главный вариант прошлой итерации важнее записи таблицы
+    if (control && ply < static_cast<int>(control->pvKeys.size()) &&
+        control->pvKeys[ply] == hashKey)
+    {
+        hashMove = control->pvMoves[ply];
+    }
+    int alphaOrig = alpha;
 
-        int dr = c1.r - c0.r;
-        int dc = c1.c - c0.c;
+    auto moves = generateMoves<White>();
 
-        bool isKing = (curP == Piece::DW || curP == Piece::DB);
-        bool isCapture = (std::abs(dr) >= 2 && std::abs(dr) == std::abs(dc));
+    if (moves.empty()) {
+        return -(WIN_SCORE - ply);
+    }
+    bool mustCapture = moves[0].captured != 0;
+    if (mustCapture) {
+        noteCaptures(moves);
+    }
 
-        if (isCapture) {
-            int stepR = (dr > 0) ? 1 : -1;
-            int stepC = (dc > 0) ? 1 : -1;
+    // Выборочность только вне главного варианта, без обязательной рубки
+    // и вдали от оценок выигрыша
+    bool pvNode = beta - alpha > 1;
+    bool selective = !pvNode && !mustCapture &&
+        std::abs(alpha) < WIN_THRESHOLD && std::abs(beta) < WIN_THRESHOLD;
+    bool futile = false;
+    if (selective && depth <= 3 && (selectivity.futilityPruning || selectivity.razoring)) {
+        int staticEval = White ? evaluateBoard() : -evaluateBoard();
+        if (depth <= 2 && selectivity.futilityPruning) {
+            futile = staticEval + selectivity.futilityMargin[depth] <= alpha;
+        }
+        if (depth == 3 && selectivity.razoring && staticEval + selectivity.razorMargin <= alpha) {
+            --depth;
+            if (control) {
+                control->stats.razorings++;
+            }
+        }
+    }
 
-            bool foundEnemy = false;
-            int rr = c0.r + stepR;
-            int cc = c0.c + stepC;
-            while (true) {
-                if (rr == c1.r && cc == c1.c) break;
-                if (!isValidPos(rr, cc)) {
-                    board = backupBoard;
-                    whiteToMove = savedWhiteToMove;
-                    return false;
-                }
-                if (isColor(board[rr][cc], !whiteToMove)) {
-                    board[rr][cc] = Piece::EMPTY;
-                    foundEnemy = true;
+    // Порядок перебора; bestIndex — номер в исходном списке генератора
+    MoveBuffer<int> order(moves.size());
+    orderMoves(moves, hashMove, ply, order.get());
+    int bestIndex = order[0];
+    int bestScore = -INFINITE_SCORE;
+
+    for (size_t k = 0; k < moves.size(); k++) {
+        int i = order[k];
+        Undo u = makeMoveFor<White>(moves[i]);
+        int score;
+        if (k == 0) {
+            score = -negamax<!White>(depth - 1, -beta, -alpha, ply + 1);
+        }
+        else {
+            // Тихий ход: не рубка, не превращение и не заставляет соперника рубить
+            bool quiet = selective && !u.captured && !u.promoted && !hasCaptureFor<!White>();
+            if (quiet && futile) {
+                unmakeMoveFor<White>(u);
+                if (control) {
+                    control->stats.futilityPrunes++;
                 }
-                rr += stepR;
-                cc += stepC;
+                continue;
             }
-            if (!foundEnemy) {
-                board = backupBoard;
-                whiteToMove = savedWhiteToMove;
-                return false;
+            int reduction = 0;
+            if (quiet && selectivity.lateMoveReductions && depth >= selectivity.lmrMinDepth &&
+                static_cast<int>(k) >= selectivity.lmrMinMoves)
+            {
+                reduction = std::min(selectivity.lmrReduction, depth - 1);
             }
-        }
-        else {
-            if (std::abs(dr) != std::abs(dc)) {
-                board = backupBoard;
-                whiteToMove = savedWhiteToMove;
-                return false;
+            score = -negamax<!White>(depth - 1 - reduction, -alpha - 1, -alpha, ply + 1);
+            if (reduction > 0 && control) {
+                control->stats.reductions++;
             }
-            if (!isKing) {
-                if (std::abs(dr) != 1) {
-                    board = backupBoard;
-                    whiteToMove = savedWhiteToMove;
-                    return false;
-                }
-                if (curP == Piece::W && dr < 0) {
-                    board = backupBoard;
-                    whiteToMove = savedWhiteToMove;
-                    return false;
-                }
-                if (curP == Piece::B && dr > 0) {
-                    board = backupBoard;
-                    whiteToMove = savedWhiteToMove;
-                    return false;
+            if (reduction > 0 && score > alpha) {
+                if (control) {
+                    control->stats.reSearches++;
                 }
+                score = -negamax<!White>(depth - 1, -alpha - 1, -alpha, ply + 1);
             }
-            else {
-                int stepR = (dr > 0) ? 1 : -1;
-                int stepC = (dc > 0) ? 1 : -1;
-                int steps = std::abs(dr);
-                int rr = c0.r + stepR, cc = c0.c + stepC;
-                for (int st = 1; st < steps; ++st) {
-                    if (board[rr][cc] != Piece::EMPTY) {
-                        board = backupBoard;
-                        whiteToMove = savedWhiteToMove;
-                        return false;
-                    }
-                    rr += stepR;
-                    cc += stepC;
-                }
+            if (score > alpha && score < beta) {
+                score = -negamax<!White>(depth - 1, -beta, -alpha, ply + 1);
             }
         }
+        unmakeMoveFor<White>(u);
+        if (control && *control->stop) {
+            return 0;
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            bestIndex = i;
+        }
+        if (bestScore > alpha) {
+            alpha = bestScore;
+        }
+        if (alpha >= beta) {
+            noteCutoff(moves[i], static_cast<int>(k), depth, ply);
+            break; // отсечение
+        }
     }
 
-    // Ставим шашку в конечную клетку
-    Coord end = move.to();
-    board[end.r][end.c] = curP;
+    Bound bound = bestScore <= alphaOrig ? Bound::UPPER
+        : bestScore >= beta ? Bound::LOWER
+        : Bound::EXACT;
+    tt->store(hashKey, scoreToTT(bestScore, ply), depth, bound, bestIndex);
+    return bestScore;
+}
 
-    // Превращение в дамку
-    if (curP == Piece::W && end.r == BOARD_SIZE - 1) {
-        board[end.r][end.c] = Piece::DW;
+// Поиск на горизонте: пока у стороны хода есть обязательная рубка, позиция
+// не спокойна, и оцениваем её только после всех рубок. Отказаться от рубки
+// нельзя, поэтому статической оценки «стоя на месте» нет.
+template<bool White>
+int CheckersBoard::quiescence(int alpha, int beta, int ply) {
+    if (searchAborted()) {
+        return 0;
+    }
+    if (control) {
+        control->stats.quiescenceNodes++;
     }
-    else if (curP == Piece::B && end.r == 0) {
-        board[end.r][end.c] = Piece::DB;
+    if (!hasCaptureFor<White>()) {
+        int eval = evaluateBoard();
+        return White ? eval : -eval;
     }
 
-    whiteToMove = !whiteToMove;
-    return true;
+    auto moves = generateMoves<White>();
+    noteCaptures(moves);
+    int bestScore = -INFINITE_SCORE;
+    for (const auto& mv : moves) {
+        Undo u = makeMoveFor<White>(mv);
+        int score = -quiescence<!White>(-beta, -alpha, ply + 1);
+        unmakeMoveFor<White>(u);
+        if (control && *control->stop) {
+            return 0;
+        }
+        bestScore = std::max(bestScore, score);
+        alpha = std::max(alpha, bestScore);
+        if (alpha >= beta) {
+            break; // отсечение
+        }
+    }
+    return bestScore;
 }
 
-// Оценка позиции
-int CheckersBoard::evaluateBoard() const {
-    int score = 0;
-    for (int r = 0; r < BOARD_SIZE; ++r) {
-        for (int c = 0; c < BOARD_SIZE; ++c) {
-            Piece p = board[r][c];
-            switch (p) {
-            case Piece::W:  score += 1;  break;
-            case Piece::DW: score += 3;  break;
-            case Piece::B:  score -= 1;  break;
-            case Piece::DB: score -= 3;  break;
-            default: break;
+// Порядок перебора ходов: ход из таблицы / главного варианта, затем рубки
+// (длинные цепочки раньше), затем два хода-убийцы этого ply, затем по таблице истории.
+// В order записываются номера ходов в исходном списке генератора.
+void CheckersBoard::orderMoves(const MoveList& moves, int hashMove, int ply, int* order) const {
+    const int HASH_SCORE = std::numeric_limits<int>::max();
+    const int CAPTURE_SCORE = 1 << 30;
+    const int KILLER_SCORE = 1 << 29;
+
+    MoveBuffer<int> scores(moves.size());
+    int n = static_cast<int>(moves.size());
+    for (int i = 0; i < n; i++) {
+        const Move& mv = moves[i];
+        int score = 0;
+        if (i == hashMove) {
+            score = HASH_SCORE;
+        }
+        else if (mv.captured) {
+            score = CAPTURE_SCORE + std::popcount(mv.captured) * 1024;
+        }
+        else if (control) {
+            uint16_t key = quietMoveKey(mv);
+            if (ply < MAX_PLY && control->killers[ply][0] == key) {
+                score = KILLER_SCORE + 1;
+            }
+            else if (ply < MAX_PLY && control->killers[ply][1] == key) {
+                score = KILLER_SCORE;
+            }
+            else {
+                score = control->history[key >> 8][key & 0xFF];
             }
         }
+        // Сортировка вставками: списки короткие, порядок равных сохраняется
+        int j = i;
+        while (j > 0 && scores[j - 1] < score) {
+            scores[j] = scores[j - 1];
+            order[j] = order[j - 1];
+            --j;
+        }
+        scores[j] = score;
+        order[j] = i;
     }
-    return score;
 }
 
-// Minimax с альфа-бета и ограниченной параллельностью
-int CheckersBoard::minimax(int depth, int alpha, int beta, bool maximizingPlayer)
-{
-    if (depth == 0) {
-        return evaluateBoard();
+// Отсечение по beta: статистика, ходы-убийцы и история для тихих ходов
+void CheckersBoard::noteCutoff(const Move& move, int moveNumber, int depth, int ply) {
+    if (!control) {
+        return;
     }
-    bool savedTurn = whiteToMove;
-    whiteToMove = maximizingPlayer;
-    auto moves = getAllPossibleMoves(maximizingPlayer);
-    whiteToMove = savedTurn;
+    control->stats.betaCutoffs++;
+    if (moveNumber == 0) {
+        control->stats.firstMoveCutoffs++;
+    }
+    if (move.captured) {
+        return;
+    }
+    uint16_t key = quietMoveKey(move);
+    if (ply < MAX_PLY && control->killers[ply][0] != key) {
+        control->killers[ply][1] = control->killers[ply][0];
+        control->killers[ply][0] = key;
+    }
+    int& h = control->history[key >> 8][key & 0xFF];
+    h = std::min(h + depth * depth, HISTORY_LIMIT);
+}
 
-    if (moves.empty()) {
-        return maximizingPlayer ? -9999 : 9999;
-    }
-    bool useParallel = (depth == 5);
-
-    if (maximizingPlayer) {
-        int maxEval = std::numeric_limits<int>::min();
-
-        if (useParallel) {
-            // Параллельный перебор 
-            std::vector<std::thread> threads;
-            threads.reserve(moves.size());
-            std::vector<int> results(moves.size(), std::numeric_limits<int>::min());
-
-            for (size_t i = 0; i < moves.size(); i++) {
-                threads.emplace_back(
-                    [this, &moves, i, depth, alpha, beta, &results]()
-                    {
-                        CheckersBoard temp = *this;
-                        temp.whiteToMove = true; // ход белых
-                        if (!temp.makeMove(moves[i])) {
-                            // Если ход невозможен
-                            results[i] = std::numeric_limits<int>::min() + 1;
-                            return;
-                        }
-                        int localAlpha = alpha;
-                        int localBeta = beta;
-                        // Глубже не параллелим (depth-1 < 5):
-                        int val = temp.minimax(depth - 1, localAlpha, localBeta, false);
-                        results[i] = val;
-                    }
-                );
-            }
-            for (auto& t : threads) {
-                t.join();
-            }
-            for (auto val : results) {
-                if (val > maxEval) {
-                    maxEval = val;
-                }
-                if (maxEval > alpha) {
-                    alpha = maxEval;
-                }
-                if (beta <= alpha) {
-                    break; // отсечение
-                }
-            }
+// Самая длинная цепочка рубки среди ходов узла (рубка обязательна: рубят все ходы)
+void CheckersBoard::noteCaptures(const MoveList& moves) {
+    if (!control) {
+        return;
+    }
+    for (const auto& mv : moves) {
+        control->stats.maxCaptureChain = std::max(control->stats.maxCaptureChain, std::popcount(mv.captured));
+    }
+}
+
+// Клетки тихого хода, упакованные как from << 8 | to
+uint16_t CheckersBoard::quietMoveKey(const Move& move) {
+    return static_cast<uint16_t>(move.fromSquare() << 8 | move.toSquare());
+}
+
+// Одна итерация корневого перебора в окне (alpha, beta), оценка с точки зрения
+// стороны хода; PVS, как в negamax. Лучший ход прошлой итерации стоит первым.
+// Возвращает номер лучшего хода или -1, если итерация прервана.
+// При выходе за окно bestScore — лишь граница: bestScore <= alpha или >= beta.
+int CheckersBoard::searchRoot(const MoveList& moves, int depth, int alpha, int beta, int& bestScore) {
+    int bestIndex = -1;
+    bestScore = -INFINITE_SCORE;
+    // Ответ соперника: специализация по стороне, ходящей после хода из корня
+    auto child = [this](int d, int a, int b) {
+        return whiteToMove ? -negamax<true>(d, -b, -a, 1) : -negamax<false>(d, -b, -a, 1);
+    };
+
+    for (size_t i = 0; i < moves.size(); i++) {
+        Undo u = makeMoveUnchecked(moves[i]);
+        int score;
+        if (i == 0) {
+            score = child(depth - 1, alpha, beta);
         }
         else {
-            // Однопоточно
-            for (auto& mv : moves) {
-                CheckersBoard temp = *this;
-                temp.whiteToMove = true;
-                if (!temp.makeMove(mv)) {
-                    continue;
-                }
-                int val = temp.minimax(depth - 1, alpha, beta, false);
-                if (val > maxEval) {
-                    maxEval = val;
-                }
-                if (maxEval > alpha) {
-                    alpha = maxEval;
-                }
-                if (beta <= alpha) {
-                    break; // отсечение
-                }
+            score = child(depth - 1, alpha, alpha + 1);
+            if (score > alpha && score < beta) {
+                score = child(depth - 1, alpha, beta);
             }
         }
-        return maxEval;
-    }
-    else {
-        // minimizingPlayer
-        int minEval = std::numeric_limits<int>::max();
-
-        if (useParallel) {
-            std::vector<std::thread> threads;
-            threads.reserve(moves.size());
-            std::vector<int> results(moves.size(), std::numeric_limits<int>::max());
-
-            for (size_t i = 0; i < moves.size(); i++) {
-                threads.emplace_back(
-                    [this, &moves, i, depth, alpha, beta, &results]()
-                    {
-                        CheckersBoard temp = *this;
-                        temp.whiteToMove = false; // ход чёрных
-                        if (!temp.makeMove(moves[i])) {
-                            results[i] = std::numeric_limits<int>::max() - 1;
-                            return;
-                        }
-                        int localAlpha = alpha;
-                        int localBeta = beta;
-                        int val = temp.minimax(depth - 1, localAlpha, localBeta, true);
-                        results[i] = val;
-                    }
-                );
-            }
-            for (auto& t : threads) {
-                t.join();
-            }
-            for (auto val : results) {
-                if (val < minEval) {
-                    minEval = val;
-                }
-                if (minEval < beta) {
-                    beta = minEval;
-                }
-                if (beta <= alpha) {
-                    break; // отсечение
-                }
-            }
+        unmakeMove(u);
+        if (control && *control->stop) {
+            return -1;
         }
-        else {
-            for (auto& mv : moves) {
-                CheckersBoard temp = *this;
-                temp.whiteToMove = false;
-                if (!temp.makeMove(mv)) {
-                    continue;
-                }
-                int val = temp.minimax(depth - 1, alpha, beta, true);
-                if (val < minEval) {
-                    minEval = val;
-                }
-                if (minEval < beta) {
-                    beta = minEval;
-                }
-                if (beta <= alpha) {
-                    break;
-                }
-            }
+        if (score > bestScore) {
+            bestScore = score;
+            bestIndex = static_cast<int>(i);
+        }
+        alpha = std::max(alpha, score);
+        if (alpha >= beta) {
+            break;
         }
-        return minEval;
     }
+    return bestIndex;
 }
 
-// Возвращаем лучший ход для текущего whiteToMove
-Move CheckersBoard::getBestMove(int depth) {
-    bool maximizing = whiteToMove;
-    auto moves = getAllPossibleMoves(maximizing);
+// Оценка позиции по таблицам окончаний (с точки зрения белых).
+// Ближе к смене материала — лучше для выигрывающей стороны.
+bool CheckersBoard::probeTablebases(int ply, int& score) const {
+    if (std::popcount(occupiedBB()) > tb->maxPieces()) {
+        return false;
+    }
+    TBEntry entry;
+    if (!tb->probe(whiteBB, blackBB, kingsBB, whiteToMove, entry)) {
+        return false;
+    }
+    score = 0;
+    if (entry.wdl == WDL::WIN) {
+        score = TB_WIN_SCORE - ply - entry.distance;
+    }
+    else if (entry.wdl == WDL::LOSS) {
+        score = -(TB_WIN_SCORE - ply - entry.distance);
+    }
+    if (!whiteToMove) {
+        score = -score;
+    }
+    return true;
+}
 
-    if (moves.empty()) {
-        return Move();
+// Ход в корне прямо по таблицам окончаний: выигрывающая сторона сокращает
+// расстояние до смены материала, проигрывающая — тянет. Перебор не нужен.
+// Рубка или превращение и есть смена материала: расстояние после них
+// считается в другой таблице и с расстояниями этой несравнимо, поэтому
+// такой ход оценивается расстоянием 0 — выигрывающий не откладывает его.
+bool CheckersBoard::tablebaseRootMove(const MoveList& moves, SearchResult& result) {
+    if (std::popcount(occupiedBB()) > tb->maxPieces()) {
+        return false;
+    }
+    bool maximizing = whiteToMove;
+    int bestIndex = -1;
+    int bestEval = 0;
+    for (size_t i = 0; i < moves.size(); ++i) {
+        Undo u = makeMoveUnchecked(moves[i]);
+        int eval = 0;
+        bool found = probeTablebases(1, eval);
+        unmakeMove(u);
+        if (!found) {
+            return false;
+        }
+        if ((u.captured != 0 || u.promoted) && eval != 0) {
+            eval = eval > 0 ? TB_WIN_SCORE - 1 : -(TB_WIN_SCORE - 1);
+        }
+        if (bestIndex < 0 || (maximizing ? eval > bestEval : eval < bestEval)) {
+            bestEval = eval;
+            bestIndex = static_cast<int>(i);
+        }
     }
+    result.bestMove = moves[bestIndex];
+    result.score = bestEval;
+    result.depth = 1;
+    result.nodes = moves.size();
+    result.pv.assign(1, result.bestMove);
+    return true;
+}
 
-    Move bestMove;
-    int bestEval = maximizing ? std::numeric_limits<int>::min()
-        : std::numeric_limits<int>::max();
+// Главный вариант из таблицы транспозиций, не длиннее maxLength (и MAX_PLY).
+// Пишется в pv, чтобы итерации переиспользовали его память
+void CheckersBoard::extractPv(const Move& first, int maxLength, std::vector<Move>& pv) {
+    Undo undos[MAX_PLY];
+    size_t length = static_cast<size_t>(std::clamp(maxLength, 1, MAX_PLY));
+    pv.clear();
+    undos[0] = makeMoveUnchecked(first);
+    pv.push_back(first);
+    while (pv.size() < length) {
+        TTEntry entry;
+        if (!tt->probe(hashKey, entry) || entry.moveIndex < 0) {
+            break;
+        }
+        auto moves = getAllPossibleMoves(whiteToMove);
+        if (entry.moveIndex >= static_cast<int>(moves.size())) {
+            break;
+        }
+        undos[pv.size()] = makeMoveUnchecked(moves[entry.moveIndex]);
+        pv.push_back(moves[entry.moveIndex]);
+    }
+    for (size_t i = pv.size(); i-- > 0;) {
+        unmakeMove(undos[i]);
+    }
+}
 
-    for (auto& mv : moves) {
-        CheckersBoard temp = *this;
-        temp.whiteToMove = maximizing;
-        if (!temp.makeMove(mv)) {
-            continue;
+// Итеративное углубление 1, 2, 3, ... на этой доске до maxDepth или до остановки.
+// Возвращает результат последней полностью завершённой итерации.
+SearchResult CheckersBoard::iterativeDeepening(MoveList moves, int maxDepth, int firstDepth) {
+    SearchResult result;
+    result.bestMove = moves[0];
+    int previous = 0;  // оценка прошлой итерации с точки зрения стороны хода
+
+    // Память главного варианта, статистики и промежуточного итога берётся
+    // один раз: итерации и узлы внутри них кучу не трогают
+    size_t plies = static_cast<size_t>(std::clamp(maxDepth, 1, MAX_PLY));
+    result.pv.reserve(plies);
+    control->pvKeys.reserve(plies);
+    control->pvMoves.reserve(plies);
+    control->stats.depths.reserve(plies);
+    bool reportProgress = control->limits && control->limits->progress;
+    SearchProgress progress;
+    if (reportProgress) {
+        progress.pv.reserve(plies);
+    }
+    for (int depth = firstDepth; depth <= maxDepth; ++depth) {
+        auto iterationStart = std::chrono::steady_clock::now();
+        uint64_t nodesBefore = searchNodes;
+
+        // Окно стремления вокруг прошлой оценки; при выходе за него окно
+        // расширяется в сторону выхода вдвое больше прежнего, пока оценка не попадёт внутрь
+        int delta = ASPIRATION_WINDOW;
+        int alpha = -INFINITE_SCORE;
+        int beta = INFINITE_SCORE;
+        if (depth >= ASPIRATION_MIN_DEPTH && std::abs(previous) < WIN_THRESHOLD) {
+            alpha = previous - delta;
+            beta = previous + delta;
         }
-        int eval = temp.minimax(depth - 1,
-            std::numeric_limits<int>::min(),
-            std::numeric_limits<int>::max(),
-            !maximizing);
-        if (maximizing) {
-            if (eval > bestEval) {
-                bestEval = eval;
-                bestMove = mv;
+        int score = 0;
+        int best;
+        while (true) {
+            best = searchRoot(moves, depth, alpha, beta, score);
+            if (best < 0) {
+                break;
             }
-        }
-        else {
-            if (eval < bestEval) {
-                bestEval = eval;
-                bestMove = mv;
+            if (score <= alpha && alpha > -INFINITE_SCORE) {
+                alpha = std::max(score - delta, -INFINITE_SCORE);
+            }
+            else if (score >= beta && beta < INFINITE_SCORE) {
+                // Ход, превысивший окно, перепроверяется первым
+                std::rotate(moves.begin(), moves.begin() + best, moves.begin() + best + 1);
+                beta = std::min(score + delta, INFINITE_SCORE);
+            }
+            else {
+                break;
             }
+            delta *= 2;
+        }
+        if (best < 0) {
+            break;
+        }
+        previous = score;
+        int eval = whiteToMove ? score : -score;
+        DepthStats iteration;
+        iteration.depth = depth;
+        iteration.score = eval;
+        iteration.nodes = searchNodes - nodesBefore;
+        iteration.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - iterationStart).count();
+        control->stats.depths.push_back(iteration);
+        // Лучший ход — в начало списка для следующей итерации
+        std::rotate(moves.begin(), moves.begin() + best, moves.begin() + best + 1);
+        result.bestMove = moves[0];
+        result.score = eval;
+        result.depth = depth;
+        extractPv(moves[0], depth, result.pv);
+
+        // Главный вариант ведёт упорядочивание следующей итерации
+        control->pvKeys.clear();
+        control->pvMoves.clear();
+        Undo undos[MAX_PLY];
+        for (size_t i = 0; i < result.pv.size(); ++i) {
+            const Move& mv = result.pv[i];
+            auto list = getAllPossibleMoves(whiteToMove);
+            auto it = std::find_if(list.begin(), list.end(),
+                [&mv](const Move& m) { return m == mv; });
+            control->pvKeys.push_back(hashKey);
+            control->pvMoves.push_back(static_cast<int>(it - list.begin()));
+            undos[i] = makeMoveUnchecked(mv);
+        }
+        for (size_t i = result.pv.size(); i-- > 0;) {
+            unmakeMove(undos[i]);
+        }
+        if (reportProgress) {
+            progress.bestMove = result.bestMove;
+            progress.depth = depth;
+            progress.score = eval;
+            progress.nodes = searchNodes;
+            progress.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - control->start).count();
+            progress.pv = result.pv;
+            control->limits->progress(progress);
+        }
+
+        // Единственный ход или найден выигрыш — дальше искать незачем
+        if (moves.size() == 1 || std::abs(eval) >= WIN_THRESHOLD) {
+            break;
         }
     }
-    return bestMove;
+    return result;
+}
+
+// Параллельный поиск Lazy SMP (или MonteCarloTree::search, если задано дерево):
+// основной поток и помощники из общего пула
+// независимо углубляются на своих копиях доски и делят таблицу транспозиций.
+// Помощники начинают с разной глубины и с разного первого хода, чтобы
+// расходиться по дереву; ответ берётся из основного потока.
+SearchResult CheckersBoard::search(const SearchLimits& limits) {
+    auto searchStart = std::chrono::steady_clock::now();
+    SearchResult result;
+    auto moves = getAllPossibleMoves(whiteToMove);
+    if (moves.empty()) {
+        lastStats = SearchStats();
+        return result;
+    }
+    if (tablebaseRootMove(moves, result)) {
+        finishSearch(result, searchStart);
+        return result;
+    }
+    // Одновременные поиски делят пул: по умолчанию каждый берёт свою долю
+    ThreadPool& pool = ThreadPool::instance();
+    ThreadPool::Share share(pool);
+    if (mcts) {
+        result = mcts->search(*this, limits);
+        finishSearch(result, searchStart);
+        return result;
+    }
+
+    // Флаг остановки общий для всех потоков поиска: им основной поток
+    // останавливает помощников. Внешний флаг (limits.stop) может быть общим
+    // для нескольких поисков, поэтому он только читается — в searchAborted
+    std::atomic<bool> stop{ false };
+    auto deadline = std::chrono::steady_clock::now() + limits.budget;
+    bool timeLimited = limits.budget.count() > 0;
+    tt->newSearch();
+
+    int threads = limits.threads > 0 ? limits.threads : static_cast<int>(pool.fairShare());
+    std::atomic<uint64_t> helperNodes{ 0 };
+    std::mutex statsMutex;
+    SearchStats helperStats;
+    TaskGroup helpers(pool);
+    for (int id = 1; id < threads; ++id) {
+        // Копия доски снимается здесь: к старту задачи основной поток уже меняет доску
+        helpers.run([helper = *this, &limits, &stop, &helperNodes, &statsMutex, &helperStats,
+            moves, deadline, timeLimited, id]() mutable {
+            SearchControl ctl;
+            ctl.stop = &stop;
+            ctl.externalStop = limits.stop;
+            ctl.deadline = deadline;
+            ctl.timeLimited = timeLimited;
+            helper.control = &ctl;
+            helper.searchNodes = 0;
+
+            MoveList order = moves;
+            std::rotate(order.begin(), order.begin() + id % order.size(), order.end());
+            helper.iterativeDeepening(order, limits.depth, 1 + id % 2);
+            helperNodes.fetch_add(helper.searchNodes);
+            std::lock_guard<std::mutex> lock(statsMutex);
+            helperStats.merge(ctl.stats);
+        });
+    }
+
+    SearchControl ctl;
+    ctl.stop = &stop;
+    ctl.externalStop = limits.stop;
+    ctl.deadline = deadline;
+    ctl.timeLimited = timeLimited;
+    ctl.limits = &limits;
+    ctl.start = searchStart;
+    control = &ctl;
+    searchNodes = 0;
+
+    result = iterativeDeepening(moves, limits.depth, 1);
+
+    stop.store(true);
+    helpers.wait();
+    control = nullptr;
+    result.nodes = searchNodes + helperNodes.load();
+    result.stats = ctl.stats;
+    result.stats.merge(helperStats);
+    finishSearch(result, searchStart);
+    return result;
+}
+
+// Итог поиска: общие узлы и время в статистике, копия для lastSearchStats
+// и строка JSON, если задан вывод статистики
+void CheckersBoard::finishSearch(SearchResult& result, std::chrono::steady_clock::time_point start) {
+    result.stats.nodes = result.nodes;
+    result.stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    lastStats = result.stats;
+    writeStats(result);
+}
+
+void CheckersBoard::writeStats(const SearchResult& result) const {
+    if (statsOutput) {
+        *statsOutput << "{\"position\":\"" << toPositionString() << "\""
+            << ",\"best\":\"" << moveToString(result.bestMove) << "\""
+            << ",\"score\":" << result.score
+            << ",\"depth\":" << result.depth
+            << ",\"stats\":" << result.stats.toJson() << "}\n";
+        statsOutput->flush();
+    }
+}
+
+std::string SearchStats::toJson() const {
+    std::ostringstream out;
+    out << "{\"nodes\":" << nodes
+        << ",\"qnodes\":" << quiescenceNodes
+        << ",\"betaCutoffs\":" << betaCutoffs
+        << ",\"firstMoveCutoffRate\":" << firstMoveCutoffRate()
+        << ",\"ttProbes\":" << ttProbes
+        << ",\"ttHits\":" << ttHits
+        << ",\"maxCaptureChain\":" << maxCaptureChain
+        << ",\"reductions\":" << reductions
+        << ",\"reSearches\":" << reSearches
+        << ",\"futilityPrunes\":" << futilityPrunes
+        << ",\"razorings\":" << razorings
+        << ",\"ebf\":" << effectiveBranchingFactor()
+        << ",\"seconds\":" << seconds
+        << ",\"depths\":[";
+    for (size_t i = 0; i < depths.size(); ++i) {
+        out << (i ? "," : "") << "{\"depth\":" << depths[i].depth
+            << ",\"score\":" << depths[i].score
+            << ",\"nodes\":" << depths[i].nodes
+            << ",\"seconds\":" << depths[i].seconds << "}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+// Ход из дебютной книги: случайный среди записей позиции, с вероятностью по весу
+bool CheckersBoard::bookMove(Move& move) {
+    if (!book || !book->isLoaded()) {
+        return false;
+    }
+    const BookEntry* first;
+    const BookEntry* last;
+    book->find(hashKey, first, last);
+    if (first == last) {
+        return false;
+    }
+
+    auto moves = getAllPossibleMoves(whiteToMove);
+    MoveList candidates;
+    std::vector<uint32_t> weights;
+    for (const BookEntry* e = first; e != last; ++e) {
+        if (e->moveIndex < moves.size() && e->weight > 0 &&
+            moves[e->moveIndex].fromSquare() == e->from &&
+            moves[e->moveIndex].toSquare() == e->to)
+        {
+            candidates.push_back(moves[e->moveIndex]);
+            weights.push_back(e->weight);
+        }
+    }
+    if (candidates.empty()) {
+        return false;
+    }
+    thread_local std::mt19937 rng{ std::random_device{}() };
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+    move = candidates[pick(rng)];
+    return true;
+}
+
+// Возвращаем лучший ход для текущего whiteToMove на заданной глубине
+Move CheckersBoard::getBestMove(int depth) {
+    Move move;
+    if (bookMove(move)) {
+        return move;
+    }
+    SearchLimits limits;
+    limits.depth = depth;
+    return search(limits).bestMove;
+}
+
+// Лучший ход за отведённое время
+Move CheckersBoard::getBestMove(std::chrono::milliseconds budget) {
+    Move move;
+    if (bookMove(move)) {
+        return move;
+    }
+    SearchLimits limits;
+    limits.budget = budget;
+    return search(limits).bestMove;
 }
 
 // Парсинг строки: "A3 B4 C5" -> Move
@@ -463,7 +1207,7 @@ bool CheckersBoard::parseUserMove(const std::string& input, Move& move) {
         return false;
     }
 
-    std::vector<Coord> path;
+    Move path;
     for (auto& tk : tokens) {
         if (tk.size() < 2) return false;
         char colCh = std::toupper(tk[0]);
@@ -473,201 +1217,263 @@ bool CheckersBoard::parseUserMove(const std::string& input, Move& move) {
 
         int c = colCh - 'A';      // колонка
         int r = (rowCh - '1');    // строка
-        path.push_back(Coord(r, c));
+        int s = squareIndex(r, c);
+        if (s < 0 || static_cast<int>(path.size()) >= Move::MAX_PATH) return false;
+        path.push(s);
     }
 
-    move.path = path;
+    move = path;
     return true;
 }
 
-// === Вспомогательные методы ===
-
-// Проверка границ
-bool CheckersBoard::isValidPos(int r, int c) const {
-    return (r >= 0 && r < BOARD_SIZE && c >= 0 && c < BOARD_SIZE);
+// Ход в формате ввода: "C3 D4", для цепочки рубки — "C3 E5 G3"
+std::string CheckersBoard::moveToString(const Move& move) {
+    std::string out;
+    for (size_t i = 0; i < move.size(); ++i) {
+        if (i > 0) out += ' ';
+        Coord c = move.at(i);
+        out += static_cast<char>('A' + c.c);
+        out += static_cast<char>('1' + c.r);
+    }
+    return out;
 }
 
-// Проверка, принадлежит ли шашка p данному цвету (whiteSide?)
-bool CheckersBoard::isColor(Piece p, bool whiteSide) const {
-    if (whiteSide) {
-        return (p == Piece::W || p == Piece::DW);
+// Позиция в текстовой записи (аналог FEN для шашек):
+//   "W W:B1,D1,F1 B:A6,C6 DW:E5 DB:H8"
+// Первое поле — сторона хода (W/B), далее группы W, B, DW, DB со списками клеток.
+// Пустые группы можно опускать. При ошибке доска не меняется.
+bool CheckersBoard::parsePosition(const std::string& text) {
+    std::vector<std::string> tokens;
+    {
+        std::string tmp;
+        for (char ch : text) {
+            if (std::isspace(static_cast<unsigned char>(ch))) {
+                if (!tmp.empty()) {
+                    tokens.push_back(tmp);
+                    tmp.clear();
+                }
+            }
+            else {
+                tmp.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(ch))));
+            }
+        }
+        if (!tmp.empty()) {
+            tokens.push_back(tmp);
+        }
     }
-    else {
-        return (p == Piece::B || p == Piece::DB);
+    if (tokens.empty() || (tokens[0] != "W" && tokens[0] != "B")) {
+        return false;
     }
-}
 
-// Генерация всех рубящих ходов для (r,c)
-void CheckersBoard::getAllCapturesForPiece(int r, int c, std::vector<Move>& captures) {
-    Piece p = board[r][c];
-    if (p == Piece::EMPTY) return;
+    uint32_t white = 0, black = 0, kings = 0;
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        const std::string& tk = tokens[i];
+        size_t colon = tk.find(':');
+        if (colon == std::string::npos) return false;
+        std::string tag = tk.substr(0, colon);
+        bool isWhite = (tag == "W" || tag == "DW");
+        bool isKing = (tag == "DW" || tag == "DB");
+        if (!isWhite && tag != "B" && tag != "DB") return false;
+
+        std::string list = tk.substr(colon + 1);
+        size_t pos = 0;
+        while (pos < list.size()) {
+            size_t comma = list.find(',', pos);
+            if (comma == std::string::npos) comma = list.size();
+            std::string sq = list.substr(pos, comma - pos);
+            pos = comma + 1;
+            if (sq.size() != 2 || sq[0] < 'A' || sq[0] > 'H' || sq[1] < '1' || sq[1] > '8') {
+                return false;
+            }
+            int r = sq[1] - '1';
+            int s = squareIndex(r, sq[0] - 'A');
+            if (s < 0 || ((white | black) & (1u << s))) return false;
+            // Простая на поле превращения стоять не может
+            if (!isKing && ((isWhite && r == BOARD_SIZE - 1) || (!isWhite && r == 0))) return false;
+            (isWhite ? white : black) |= 1u << s;
+            if (isKing) kings |= 1u << s;
+        }
+    }
+    // Больше шашек, чем в начальной позиции, не бывает; на этом держится длина пути хода
+    if (std::popcount(white) > MAX_SIDE_PIECES || std::popcount(black) > MAX_SIDE_PIECES) {
+        return false;
+    }
 
-    // Стартуем DFS с путём, где первая клетка — (r,c)
-    std::vector<Coord> path;
-    path.push_back(Coord(r, c));
+    whiteBB = white;
+    blackBB = black;
+    kingsBB = kings;
+    whiteToMove = (tokens[0] == "W");
+    hashKey = computeHash();
+    evalScore = computeEvaluation();
+    return true;
+}
 
-    std::vector<Move> results;
-    dfsCaptures(path, results);
-    if (!results.empty()) {
-        captures.insert(captures.end(), results.begin(), results.end());
+// Обратное к parsePosition; группы пишутся всегда, даже пустые
+std::string CheckersBoard::toPositionString() const {
+    std::string out = whiteToMove ? "W" : "B";
+    const char* tags[4] = { "W", "B", "DW", "DB" };
+    uint32_t masks[4] = {
+        whiteBB & ~kingsBB, blackBB & ~kingsBB, whiteBB & kingsBB, blackBB & kingsBB
+    };
+    for (int g = 0; g < 4; ++g) {
+        out += ' ';
+        out += tags[g];
+        out += ':';
+        bool first = true;
+        for (uint32_t bb = masks[g]; bb; bb &= bb - 1) {
+            Coord c = squareCoord(lowestSquare(bb));
+            if (!first) out += ',';
+            out += static_cast<char>('A' + c.c);
+            out += static_cast<char>('1' + c.r);
+            first = false;
+        }
     }
+    return out;
 }
 
-// Рекурсивный поиск цепочек рубки. Учитываем, что дамка может бить «далеко».
-void CheckersBoard::dfsCaptures(std::vector<Coord>& path, std::vector<Move>& results) {
-    Coord cur = path.back();
-    Piece p = board[cur.r][cur.c];
-
-    bool isKing = (p == Piece::DW || p == Piece::DB);
-    bool pIsWhite = isColor(p, true);
-
-    bool foundCapture = false;
-
-    static const int DR[4] = { 1, 1, -1, -1 };
-    static const int DC[4] = { 1, -1, 1, -1 };
-
-    for (int i = 0; i < 4; ++i) {
-        int stepR = DR[i];
-        int stepC = DC[i];
+// === Вспомогательные методы ===
 
-        if (!isKing) {
-            int nr = cur.r + 2 * stepR;
-            int nc = cur.c + 2 * stepC;
-            int mr = cur.r + stepR;
-            int mc = cur.c + stepC;
+int CheckersBoard::squareIndex(int r, int c) {
+    if (r < 0 || r >= BOARD_SIZE || c < 0 || c >= BOARD_SIZE) return -1;
+    if ((r + c) % 2 == 0) return -1;
+    return r * 4 + c / 2;
+}
 
-            if (!isValidPos(nr, nc) || !isValidPos(mr, mc)) {
-                continue;
-            }
-            if (isColor(board[mr][mc], !pIsWhite) &&
-                board[nr][nc] == Piece::EMPTY)
-            {
-                Piece savedMid = board[mr][mc];
-                Piece savedCur = board[cur.r][cur.c];
-                Piece savedLanding = board[nr][nc];
+Coord CheckersBoard::squareCoord(int s) {
+    return darkSquareCoord(s);
+}
 
-                board[cur.r][cur.c] = Piece::EMPTY;
-                board[mr][mc] = Piece::EMPTY;
-                board[nr][nc] = p;
+// Поставить шашку p (или очистить клетку) на тёмную клетку s
+void CheckersBoard::setPiece(int s, Piece p) {
+    uint32_t bit = 1u << s;
+    Coord c = squareCoord(s);
+    Piece old = pieceAt(c.r, c.c);
+    if (old != Piece::EMPTY) {
+        hashKey ^= pieceKey(old, s);
+        evalScore -= pieceValue(old, s);
+    }
+    if (p != Piece::EMPTY) {
+        hashKey ^= pieceKey(p, s);
+        evalScore += pieceValue(p, s);
+    }
+    whiteBB &= ~bit;
+    blackBB &= ~bit;
+    kingsBB &= ~bit;
+    if (p == Piece::W || p == Piece::DW) whiteBB |= bit;
+    if (p == Piece::B || p == Piece::DB) blackBB |= bit;
+    if (p == Piece::DW || p == Piece::DB) kingsBB |= bit;
+}
 
-                path.push_back(Coord(nr, nc));
-                dfsCaptures(path, results);
+// Генерация всех рубящих ходов для шашки стороны White на клетке s
+template<bool White>
+void CheckersBoard::getAllCapturesForPiece(int s, MoveList& captures) {
+    uint32_t bit = 1u << s;
+    uint32_t enemy = White ? blackBB : whiteBB;
+
+    // Стартуем DFS с путём, где первая клетка — s.
+    // Сама шашка уходит с исходной клетки, поэтому снимаем её с occupied.
+    Move path;
+    path.push(s);
+    if (kingsBB & bit) {
+        dfsCaptures<true>(path, enemy, occupiedBB() & ~bit, captures);
+    }
+    else {
+        dfsCaptures<false>(path, enemy, occupiedBB() & ~bit, captures);
+    }
+}
 
-                path.pop_back();
-                board[cur.r][cur.c] = savedCur;
-                board[mr][mc] = savedMid;
-                board[nr][nc] = savedLanding;
+// Рекурсивный поиск цепочек рубки. Учитываем, что дамка может бить «далеко».
+// Доску не трогаем: срубленные шашки снимаются с локальных масок enemy/occupied
+// и копятся в path.captured.
+template<bool King>
+void CheckersBoard::dfsCaptures(Move& path, uint32_t enemy, uint32_t occupied, MoveList& results)
+{
+    int cur = path.toSquare();
+    bool foundCapture = false;
 
+    for (int d = 0; d < 4; ++d) {
+        if constexpr (!King) {
+            int mid = SQ.neighbor[cur][d];
+            if (mid < 0) continue;
+            int land = SQ.neighbor[mid][d];
+            if (land < 0) continue;
+
+            if ((enemy & (1u << mid)) && !(occupied & (1u << land))) {
+                path.push(land);
+                path.captured |= 1u << mid;
+                dfsCaptures<false>(path, enemy & ~(1u << mid),
+                    occupied & ~(1u << mid), results);
+                path.captured &= ~(1u << mid);
+                path.pop();
                 foundCapture = true;
             }
         }
         else {
-            int r2 = cur.r + stepR;
-            int c2 = cur.c + stepC;
-
-            bool foundOpponent = false;
-            int oppR = -1, oppC = -1;
-            while (isValidPos(r2, c2)) {
-                if (board[r2][c2] != Piece::EMPTY) {
-                    if (!foundOpponent && isColor(board[r2][c2], !pIsWhite)) {
-                        foundOpponent = true;
-                        oppR = r2;
-                        oppC = c2;
-                    }
-                    else {
-                        break;
-                    }
-                }
-                r2 += stepR;
-                c2 += stepC;
+            // Первая занятая клетка на луче должна быть шашкой соперника
+            uint32_t hits = RAYS.mask[cur][d] & occupied;
+            if (!hits) {
+                continue;
             }
-
-            if (!foundOpponent) {
+            int opp = nearestOnRay(hits, d);
+            if (!(enemy & (1u << opp))) {
                 continue;
             }
 
-            int landingR = oppR + stepR;
-            int landingC = oppC + stepC;
-
-            while (isValidPos(landingR, landingC) &&
-                board[landingR][landingC] == Piece::EMPTY)
-            {
-                // Виртуально рубим
-                Piece savedOpp = board[oppR][oppC];
-                Piece savedCur = board[cur.r][cur.c];
-                Piece savedLand = board[landingR][landingC];
-
-                board[cur.r][cur.c] = Piece::EMPTY;
-                board[oppR][oppC] = Piece::EMPTY;
-                board[landingR][landingC] = p;
-
-                path.push_back(Coord(landingR, landingC));
-                dfsCaptures(path, results);
-
-                // Откат
-                path.pop_back();
-                board[cur.r][cur.c] = savedCur;
-                board[oppR][oppC] = savedOpp;
-                board[landingR][landingC] = savedLand;
-
+            // Все пустые клетки за соперником до следующей занятой — поля приземления
+            int free = 0;
+            firstBlocker(opp, d, occupied, free);
+            uint32_t nextEnemy = enemy & ~(1u << opp);
+            uint32_t nextOccupied = occupied & ~(1u << opp);
+            for (int i = 0; i < free; ++i) {
+                int land = RAYS.square[opp][d][i];
+                path.push(land);
+                path.captured |= 1u << opp;
+                dfsCaptures<true>(path, nextEnemy, nextOccupied, results);
+                path.captured &= ~(1u << opp);
+                path.pop();
                 foundCapture = true;
-                landingR += stepR;
-                landingC += stepC;
             }
         }
     }
 
     if (!foundCapture) {
         if (path.size() > 1) {
-            results.push_back(Move(path));
+            results.push_back(path);
         }
     }
 }
 
-// Генерация обычных ходов (без взятия)
-void CheckersBoard::getAllNormalMovesForPiece(int r, int c, std::vector<Move>& moves) {
-    Piece p = board[r][c];
-    if (p == Piece::EMPTY) return;
-
-    static const int DR[4] = { 1, -1, 1, -1 };
-    static const int DC[4] = { 1, 1, -1, -1 };
-
-    bool isKing = (p == Piece::DW || p == Piece::DB);
-
-    for (int i = 0; i < 4; ++i) {
-        int stepR = DR[i];
-        int stepC = DC[i];
-
-        if (!isKing) {
-            int nr = r + stepR;
-            int nc = c + stepC;
-            if (p == Piece::W && stepR < 0) {
-                continue;
-            }
-            if (p == Piece::B && stepR > 0) {
-                continue;
-            }
-
-            if (isValidPos(nr, nc) && board[nr][nc] == Piece::EMPTY) {
-                // Формируем ход
-                std::vector<Coord> path;
-                path.push_back(Coord(r, c));
-                path.push_back(Coord(nr, nc));
-                moves.push_back(Move(path));
+// Генерация обычных ходов (без взятия) для шашки стороны White на клетке s
+template<bool White>
+void CheckersBoard::getAllNormalMovesForPiece(int s, MoveList& moves) {
+    // Белые простые идут вниз по доске (r растёт): направления 0 и 1, чёрные — 2 и 3.
+    // Дамки: (1,1), (-1,1), (1,-1), (-1,-1)
+    static constexpr int MAN_DIRS[2] = { White ? 0 : 2, White ? 1 : 3 };
+    static constexpr int KING_DIRS[4] = { 0, 2, 1, 3 };
+
+    uint32_t bit = 1u << s;
+    uint32_t empty = ~occupiedBB();
+    Move mv;
+    mv.push(s);
+    mv.push(s);
+
+    if (!(kingsBB & bit)) {
+        for (int d : MAN_DIRS) {
+            uint32_t target = shiftDir(bit, d) & empty;
+            if (target) {
+                mv.path[1] = static_cast<uint8_t>(lowestSquare(target));
+                moves.push_back(mv);
             }
         }
-        else {
-            int nr = r + stepR;
-            int nc = c + stepC;
-            while (isValidPos(nr, nc) && board[nr][nc] == Piece::EMPTY) {
-                std::vector<Coord> path;
-                path.push_back(Coord(r, c));
-                path.push_back(Coord(nr, nc));
-                moves.push_back(Move(path));
-
-                nr += stepR;
-                nc += stepC;
-            }
+        return;
+    }
+    // Дамка скользит по лучу до первой занятой клетки
+    for (int d : KING_DIRS) {
+        int free = 0;
+        firstBlocker(s, d, ~empty, free);
+        for (int i = 0; i < free; ++i) {
+            mv.path[1] = static_cast<uint8_t>(RAYS.square[s][d][i]);
+            moves.push_back(mv);
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,504 @@
+﻿#include "../Include/dfpn.h"
+#include <algorithm>
+
+namespace {
+
+// «Бесконечное» число доказательства; суммы насыщаются на нём
+const uint32_t INF = 1u << 30;
+// Время проверяется раз в столько вызовов поиска
+const uint64_t CLOCK_INTERVAL = 4096;
+
+uint32_t saturatedAdd(uint32_t a, uint32_t b) {
+    return static_cast<uint32_t>(std::min<uint64_t>(INF, static_cast<uint64_t>(a) + b));
+}
+
+// Ключи счётчика полуходов без прогресса, смешиваются с ключом Зобриста доски.
+// Ненулевые все, включая 0: ключ позиции без счётчика — запись её границ
+struct QuietKeys {
+    uint64_t key[256];
+};
+
+constexpr QuietKeys buildQuietKeys() {
+    QuietKeys keys{};
+    uint64_t state = 0xD1F2A3B4C5D6E7F8ull;
+    for (int i = 0; i < 256; ++i) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        keys.key[i] = z ^ (z >> 31);
+    }
+    return keys;
+}
+
+constexpr QuietKeys QUIET_KEYS = buildQuietKeys();
+
+} // namespace
+
+ProofNumberSolver::ProofNumberSolver(size_t megabytes) {
+    resize(megabytes);
+}
+
+void ProofNumberSolver::resize(size_t megabytes) {
+    // Число корзин — степень двойки, чтобы индекс брался маской
+    size_t want = megabytes * 1024 * 1024 / sizeof(Bucket);
+    bucketCount = 1;
+    while (bucketCount * 2 <= want) {
+        bucketCount *= 2;
+    }
+    buckets.reset(new Bucket[bucketCount]);
+    stored = 0;
+}
+
+void ProofNumberSolver::clear() {
+    for (size_t i = 0; i < bucketCount; ++i) {
+        buckets[i] = Bucket();
+    }
+    stored = 0;
+}
+
+// Ключ узла — позиции со счётчиком: под ним хранятся числа поиска узла,
+// а под ключом позиции — границы счётчика, при которых она решена
+uint64_t ProofNumberSolver::nodeKey(int quiet) const {
+    return board.hash() ^ QUIET_KEYS.key[quiet];
+}
+
+// Ничья — успех стороны хода, если она доказывающая и цель «не проиграть»
+// или она защищающаяся и цель доказывающего — выигрыш
+bool ProofNumberSolver::drawSucceeds(bool whiteToMove) const {
+    bool prover = whiteToMove == proverWhite;
+    return prover == drawIsWin;
+}
+
+// Выгодность счётчика для стороны хода: чем больше, тем легче ей достичь
+// цели. Ближе к ничьей — лучше той стороне, для которой ничья — успех:
+// всё, что соперник успевает за меньшее число полуходов, он успеет и за большее.
+int ProofNumberSolver::goodness(int quiet, bool whiteToMove) const {
+    return drawSucceeds(whiteToMove) ? quiet : drawPlies - quiet;
+}
+
+// Результат узла по таблицам окончаний; false — позиции в таблицах нет
+// или её результат при этом счётчике таблицы не определяют.
+// Таблицы строятся без правила ничьей, а оно только превращает часть
+// побед в ничьи: ничья по таблице — ничья при любом счётчике, выигрыш —
+// не меньше ничьей, проигрыш — не больше. Выигрыш или проигрыш точен, если
+// смена материала (она же сбрасывает счётчик) наступает до срабатывания
+// правила, quiet + distance <= drawPlies, и так же успевает каждая следующая:
+// правило не короче расстояний всех таблиц, достижимых из корня
+// (tablebaseDecisive). Иначе выигрыш и проигрыш доказываются перебором.
+bool ProofNumberSolver::tablebaseLeaf(int quiet, bool& success) const {
+    const Tablebases* tables = board.tablebases();
+    TBEntry entry;
+    if (!tables || !tables->probe(board.whitePieces(), board.blackPieces(), board.kingPieces(),
+        board.isWhiteToMove(), entry))
+    {
+        return false;
+    }
+    bool drawIsEnough = drawSucceeds(board.isWhiteToMove());
+    bool inTime = tablebaseDecisive && quiet + entry.distance <= drawPlies;
+    switch (entry.wdl) {
+    case WDL::WIN:
+        success = true;
+        return drawIsEnough || inTime;
+    case WDL::LOSS:
+        success = false;
+        return !drawIsEnough || inTime;
+    default:
+        success = drawIsEnough;
+        return true;
+    }
+}
+
+ProofNumberSolver::Entry* ProofNumberSolver::probe(uint64_t key) const {
+    Bucket& bucket = buckets[key & (bucketCount - 1)];
+    for (Entry& e : bucket.entries) {
+        if (e.used && e.key == key) {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+// Запись под ключ; из полной корзины вытесняется нерешённая запись
+// с наименьшей работой, записи с границами — в последнюю очередь
+ProofNumberSolver::Entry& ProofNumberSolver::slotFor(uint64_t key) {
+    Bucket& bucket = buckets[key & (bucketCount - 1)];
+    Entry* slot = nullptr;
+    for (Entry& e : bucket.entries) {
+        if (e.used && e.key == key) {
+            return e;
+        }
+        if (!e.used) {
+            if (!slot || slot->used) {
+                slot = &e;
+            }
+            continue;
+        }
+        if (slot && !slot->used) {
+            continue;
+        }
+        if (!slot || (slot->solved() && !e.solved()) || (slot->solved() == e.solved() && e.work < slot->work)) {
+            slot = &e;
+        }
+    }
+    if (!slot->used) {
+        ++stored;
+    }
+    *slot = Entry();
+    slot->used = true;
+    slot->key = key;
+    return *slot;
+}
+
+bool ProofNumberSolver::lookup(uint64_t key, int quiet, bool whiteToMove, uint32_t& phi, uint32_t& delta) const {
+    if (const Entry* bounds = probe(key)) {
+        int g = goodness(quiet, whiteToMove);
+        if (g >= bounds->provenFrom) {
+            phi = 0;
+            delta = INF;
+            return true;
+        }
+        if (g <= bounds->disprovenTo) {
+            phi = INF;
+            delta = 0;
+            return true;
+        }
+    }
+    if (const Entry* numbers = probe(key ^ QUIET_KEYS.key[quiet])) {
+        phi = numbers->phi;
+        delta = numbers->delta;
+        return true;
+    }
+    return false;
+}
+
+// Запись всегда сохраняется: иначе родитель не увидит продвижения в ребёнке
+// и будет выбирать его снова. Решённый узел расширяет границы позиции,
+// а его числа больше не нужны.
+void ProofNumberSolver::store(uint64_t key, int quiet, bool whiteToMove, uint32_t phi, uint32_t delta, uint32_t work) {
+    uint64_t numbersKey = key ^ QUIET_KEYS.key[quiet];
+    if (phi != 0 && delta != 0) {
+        Entry& numbers = slotFor(numbersKey);
+        numbers.phi = phi;
+        numbers.delta = delta;
+        numbers.work = saturatedAdd(numbers.work, work);
+    }
+    else {
+        if (Entry* numbers = probe(numbersKey)) {
+            work = saturatedAdd(work, numbers->work);
+            numbers->used = false;
+            --stored;
+        }
+        Entry& bounds = slotFor(key);
+        int g = goodness(quiet, whiteToMove);
+        if (phi == 0) {
+            bounds.provenFrom = static_cast<int16_t>(std::min<int>(bounds.provenFrom, g));
+        }
+        else {
+            bounds.disprovenTo = static_cast<int16_t>(std::max<int>(bounds.disprovenTo, g));
+        }
+        bounds.work = saturatedAdd(bounds.work, work);
+    }
+    if (stored > bucketCount * 4 * 3 / 4) {
+        collectGarbage();
+    }
+}
+
+// Сборка мусора по малым поддеревьям: удаляются нерешённые записи с работой
+// не больше медианы. Если так освобождается меньше четверти таблицы
+// (почти все записи решены), тем же правилом удаляются и решённые —
+// при построении доказательства они будут найдены заново.
+void ProofNumberSolver::collectGarbage() {
+    ++collections;
+    size_t capacity = bucketCount * 4;
+    for (int pass = 0; pass < 2 && stored > capacity / 2; ++pass) {
+        bool solvedPass = pass == 1;
+        std::vector<uint32_t> work;
+        for (size_t i = 0; i < bucketCount; ++i) {
+            for (const Entry& e : buckets[i].entries) {
+                if (e.used && e.solved() == solvedPass) {
+                    work.push_back(e.work);
+                }
+            }
+        }
+        if (work.empty()) {
+            continue;
+        }
+        auto median = work.begin() + work.size() / 2;
+        std::nth_element(work.begin(), median, work.end());
+        uint32_t threshold = *median;
+        for (size_t i = 0; i < bucketCount; ++i) {
+            for (Entry& e : buckets[i].entries) {
+                if (e.used && e.solved() == solvedPass && e.work <= threshold) {
+                    e.used = false;
+                    --stored;
+                }
+            }
+        }
+        if (stored <= capacity / 2) {
+            break;
+        }
+    }
+}
+
+// Дети узла дописываются в конец children; возвращает их число
+size_t ProofNumberSolver::generateChildren(int quiet) {
+    MoveList moves = board.getAllPossibleMoves(board.isWhiteToMove());
+    for (const Move& mv : moves) {
+        // Рубка и ход простой необратимы и сбрасывают счётчик
+        bool progress = mv.captured != 0 || !(board.kingPieces() & (1u << mv.fromSquare()));
+        int childQuiet = progress ? 0 : quiet + 1;
+        Undo u = board.makeMoveUnchecked(mv);
+        children.push_back({ mv, board.hash(), childQuiet });
+        board.unmakeMove(u);
+    }
+    return moves.size();
+}
+
+bool ProofNumberSolver::checkLimits() {
+    if (aborted) {
+        return true;
+    }
+    if ((stop && stop->load(std::memory_order_relaxed)) ||
+        (timeLimited && nodes % CLOCK_INTERVAL == 0 && std::chrono::steady_clock::now() >= deadline))
+    {
+        aborted = true;
+    }
+    return aborted;
+}
+
+// Multiple iterative deepening: узел ищется, пока его числа не превысят
+// пороги. Ребёнок с наименьшим delta получает пороги так, чтобы вернуться,
+// как только он перестанет быть лучшим (с запасом 1 + 1/4 от второго
+// по delta, чтобы не метаться между двумя близкими детьми).
+void ProofNumberSolver::mid(int quiet, uint32_t thPhi, uint32_t thDelta) {
+    ++nodes;
+    if (checkLimits()) {
+        return;
+    }
+    uint64_t key = board.hash();
+    bool white = board.isWhiteToMove();
+    uint64_t startNodes = nodes;
+
+    if (quiet >= drawPlies) {
+        bool success = drawSucceeds(white);
+        store(key, quiet, white, success ? 0 : INF, success ? INF : 0, 1);
+        return;
+    }
+    bool tbSuccess;
+    if (tablebaseLeaf(quiet, tbSuccess)) {
+        store(key, quiet, white, tbSuccess ? 0 : INF, tbSuccess ? INF : 0, 1);
+        return;
+    }
+    size_t first = children.size();
+    size_t count = generateChildren(quiet);
+    if (count == 0) {
+        // Ходить нечем — проигрыш стороны хода при любом счётчике:
+        // опровержение записывается для самого выгодного из них
+        store(key, drawSucceeds(white) ? drawPlies : 0, white, INF, 0, 1);
+        return;
+    }
+
+    uint32_t phi = 0, delta = 0;
+    while (true) {
+        // phi узла — наименьшее delta детей. delta — слабое число (WPNS):
+        // наибольшее phi детей плюс число прочих нерешённых, а не сумма phi,
+        // которая в позициях с транспозициями считает общие поддеревья много раз
+        phi = INF;
+        uint32_t maxPhi = 0;
+        uint32_t open = 0;
+        uint32_t secondDelta = INF;
+        size_t best = first;
+        for (size_t i = first; i < first + count; ++i) {
+            uint32_t cPhi = 1, cDelta = 1;
+            lookup(children[i].key, children[i].quiet, !white, cPhi, cDelta);
+            if (cPhi > 0) {
+                maxPhi = std::max(maxPhi, cPhi);
+                ++open;
+            }
+            if (cDelta < phi) {
+                secondDelta = phi;
+                phi = cDelta;
+                best = i;
+            }
+            else if (cDelta < secondDelta) {
+                secondDelta = cDelta;
+            }
+        }
+        delta = open == 0 ? 0 : saturatedAdd(maxPhi, open - 1);
+        if (phi >= thPhi || delta >= thDelta || aborted) {
+            break;
+        }
+
+        // delta узла дойдёт до порога, когда phi ребёнка станет наибольшим и равным thDelta - (open - 1)
+        uint32_t childThPhi = thDelta >= INF ? INF : thDelta - (open - 1);
+        uint32_t childThDelta = std::min<uint32_t>(thPhi,
+            std::max(saturatedAdd(secondDelta, 1), saturatedAdd(secondDelta, secondDelta / 4)));
+        Child child = children[best];
+        Undo u = board.makeMoveUnchecked(child.move);
+        mid(child.quiet, childThPhi, childThDelta);
+        board.unmakeMove(u);
+    }
+    children.resize(first);
+    store(key, quiet, white, phi, delta, static_cast<uint32_t>(std::min<uint64_t>(nodes - startNodes + 1, INF)));
+}
+
+// Доказать цель стороны хода в текущей позиции; false — опровергнута
+// или поиск прерван
+bool ProofNumberSolver::prove(int quiet) {
+    uint64_t key = board.hash();
+    bool white = board.isWhiteToMove();
+    uint32_t phi = 1, delta = 1;
+    if (lookup(key, quiet, white, phi, delta) && (phi == 0 || delta == 0)) {
+        return phi == 0;
+    }
+    while (!aborted) {
+        mid(quiet, INF, INF);
+        if (lookup(key, quiet, white, phi, delta) && (phi == 0 || delta == 0)) {
+            break;
+        }
+    }
+    return !aborted && phi == 0;
+}
+
+// Числа ребёнка children[index] текущей позиции; нерешённый (или вытесненный
+// из таблицы) ребёнок решается заново. false — поиск прерван.
+bool ProofNumberSolver::solveChild(size_t index, uint32_t& phi, uint32_t& delta) {
+    Child child = children[index];
+    bool white = !board.isWhiteToMove();
+    if (lookup(child.key, child.quiet, white, phi, delta) && (phi == 0 || delta == 0)) {
+        return true;
+    }
+    Undo u = board.makeMoveUnchecked(child.move);
+    prove(child.quiet);
+    board.unmakeMove(u);
+    return !aborted && lookup(child.key, child.quiet, white, phi, delta);
+}
+
+// Ребёнок среди children[first, first + count) с опровергнутой целью:
+// сперва по таблице, затем решая детей по порядку. count — если нет
+size_t ProofNumberSolver::provingChild(size_t first, size_t count) {
+    bool white = !board.isWhiteToMove();
+    for (size_t i = first; i < first + count; ++i) {
+        uint32_t phi, delta;
+        if (lookup(children[i].key, children[i].quiet, white, phi, delta) && delta == 0) {
+            return i - first;
+        }
+    }
+    for (size_t i = first; i < first + count; ++i) {
+        uint32_t phi, delta;
+        if (!solveChild(i, phi, delta)) {
+            break;
+        }
+        if (delta == 0) {
+            return i - first;
+        }
+    }
+    return count;
+}
+
+// Ход, после которого цель стороны соперника опровергнута
+bool ProofNumberSolver::winningMove(int quiet, Move& move) {
+    size_t first = children.size();
+    size_t count = generateChildren(quiet);
+    size_t best = provingChild(first, count);
+    if (best < count) {
+        move = children[first + best].move;
+    }
+    children.resize(first);
+    return best < count;
+}
+
+// Размер дерева доказательства решённого узла: у достигающего цели — один
+// ребёнок с опровергнутой целью, у не достигающего — все дети. Позиции,
+// встреченные повторно (по другому пути), не считаются.
+uint64_t ProofNumberSolver::proofSize(int quiet, std::unordered_set<uint64_t>& seen) {
+    if (!seen.insert(nodeKey(quiet)).second) {
+        return 0;
+    }
+    bool tbSuccess;
+    if (quiet >= drawPlies || tablebaseLeaf(quiet, tbSuccess)) {
+        return 1;
+    }
+    prove(quiet);
+    uint32_t phi = 1, delta = 1;
+    if (aborted || !lookup(board.hash(), quiet, board.isWhiteToMove(), phi, delta)) {
+        return 1;
+    }
+
+    uint64_t size = 1;
+    size_t first = children.size();
+    size_t count = generateChildren(quiet);
+    size_t begin = 0, end = count;
+    if (phi == 0) {
+        begin = provingChild(first, count);
+        end = std::min(begin + 1, count);
+    }
+    for (size_t i = first + begin; i < first + end && !aborted; ++i) {
+        uint32_t cPhi, cDelta;
+        if (!solveChild(i, cPhi, cDelta)) {
+            break;
+        }
+        Child child = children[i];
+        Undo u = board.makeMoveUnchecked(child.move);
+        size += proofSize(child.quiet, seen);
+        board.unmakeMove(u);
+    }
+    children.resize(first);
+    return size;
+}
+
+// Сначала доказывается выигрыш стороны хода; если он опровергнут —
+// что она не проигрывает (ничья теперь её успех)
+SolveResult ProofNumberSolver::solve(const CheckersBoard& position, const SearchLimits& limits, int quietPlies) {
+    auto start = std::chrono::steady_clock::now();
+    board = position;
+    board.setMonteCarloTree(nullptr);
+    board.setStatsOutput(nullptr);
+    proverWhite = board.isWhiteToMove();
+    stop = limits.stop;
+    timeLimited = limits.budget.count() > 0;
+    deadline = start + limits.budget;
+    nodes = 0;
+    collections = 0;
+    aborted = false;
+    children.clear();
+    int quiet = std::clamp(quietPlies, 0, drawPlies);
+    const Tablebases* tables = board.tablebases();
+    tablebaseDecisive = tables &&
+        tables->maxDistance(board.whitePieces(), board.blackPieces(), board.kingPieces()) <= drawPlies;
+
+    SolveResult result;
+    std::unordered_set<uint64_t> seen;
+    clear();
+    drawIsWin = false;
+    if (prove(quiet)) {
+        result.result = WDL::WIN;
+        winningMove(quiet, result.bestMove);
+        result.proofSize = proofSize(quiet, seen);
+    }
+    else if (!aborted) {
+        // Опровержение выигрыша — первая половина доказательства ничьей или проигрыша
+        uint64_t noWin = proofSize(quiet, seen);
+        seen.clear();
+        clear();
+        drawIsWin = true;
+        if (prove(quiet)) {
+            result.result = WDL::DRAW;
+            winningMove(quiet, result.bestMove);
+            result.proofSize = noWin + proofSize(quiet, seen);
+        }
+        else {
+            result.result = WDL::LOSS;
+            MoveList moves = board.getAllPossibleMoves(board.isWhiteToMove());
+            if (!moves.empty()) {
+                result.bestMove = moves[0];
+            }
+            result.proofSize = proofSize(quiet, seen);
+        }
+    }
+    result.solved = !aborted;
+    result.nodes = nodes;
+    result.collections = collections;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,93 @@
+﻿#include "../Include/checkers.h"
+#include "../Include/dfpn.h"
+
+// dfpntest: решатель df-pn с таблицами окончаний отвечает так же, как без них.
+//
+//   dfpntest каталог_таблиц
+//
+// Таблицы не знают правила ничьей: их выигрыш верен, только если каждая
+// фаза до смены материала укладывается в правило. Короткое правило (-q 1)
+// превращает такие выигрыши в ничьи — решатель не должен верить таблицам.
+// Позиции трёхшашечные: таблицы строит tbgen -n 3 перед тестом (ctest),
+// а без таблиц они решаются перебором за доли секунды.
+// Код возврата 0 — все результаты совпали.
+
+namespace {
+
+struct Case {
+    const char* position;
+    int drawPlies;
+};
+
+const Case CASES[] = {
+    // Выигрыш по таблицам, ничья по правилу в 1 полуход
+    { "W W: B:A4 DW:C2,G8 DB:", 1 },
+    { "W W: B:E8 DW:G6 DB:D3", 1 },
+    { "B W:H3 B:E8 DW:G2 DB:", 1 },
+    { "B W:E2 B: DW:D7 DB:F5", 1 },
+    { "B W:D3 B: DW:F5 DB:G4", 1 },
+    // Те же позиции: при более длинном правиле выигрыш настоящий
+    { "W W: B:E8 DW:G6 DB:D3", 4 },
+    { "B W:E2 B: DW:D7 DB:F5", 4 },
+    { "B W:D3 B: DW:F5 DB:G4", 60 },
+};
+
+const char* describe(const SolveResult& result) {
+    if (!result.solved) {
+        return "не решено";
+    }
+    return result.result == WDL::WIN ? "выигрыш" : result.result == WDL::LOSS ? "проигрыш" : "ничья";
+}
+
+SolveResult solveWith(const CheckersBoard& position, const Tablebases& tables, int drawPlies, int budgetMs) {
+    CheckersBoard board = position;
+    board.setTablebases(&tables);
+    ProofNumberSolver solver(16);
+    solver.setDrawPlies(drawPlies);
+    SearchLimits limits;
+    limits.budget = std::chrono::milliseconds(budgetMs);
+    return solver.solve(board, limits);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    setlocale(LC_ALL, "ru");
+    if (argc != 2) {
+        std::cout << "Использование: dfpntest каталог_таблиц\n";
+        return 1;
+    }
+    Tablebases tables;
+    if (tables.load(argv[1]) == 0) {
+        std::cout << "Нет таблиц в " << argv[1] << "\n";
+        return 1;
+    }
+    Tablebases none;
+
+    bool ok = true;
+    for (const Case& c : CASES) {
+        CheckersBoard board;
+        if (!board.parsePosition(c.position)) {
+            std::cout << "Некорректная позиция: " << c.position << "\n";
+            return 1;
+        }
+        SolveResult withTables = solveWith(board, tables, c.drawPlies, 10000);
+        SolveResult without = solveWith(board, none, c.drawPlies, 10000);
+        bool same = withTables.solved && without.solved && withTables.result == without.result;
+        std::cout << c.position << " -q " << c.drawPlies << ": с таблицами " << describe(withTables)
+            << ", без таблиц " << describe(without) << (same ? "" : "  ОШИБКА") << "\n";
+        ok = same && ok;
+    }
+
+    // Ничья по таблицам — лист при любом правиле: решается сразу
+    CheckersBoard board;
+    board.parsePosition("W W:H1 B: DW:B1 DB:C8");
+    SolveResult draw = solveWith(board, tables, ProofNumberSolver::DEFAULT_DRAW_PLIES, 2000);
+    bool drawOk = draw.solved && draw.result == WDL::DRAW;
+    std::cout << board.toPositionString() << ": " << describe(draw) << ", узлов " << draw.nodes
+        << (drawOk ? "" : "  ОШИБКА") << "\n";
+    ok = drawOk && ok;
+
+    std::cout << (ok ? "Результаты совпадают\n" : "ОШИБКА: таблицы меняют результат\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+﻿#include "../Include/engine.h"
+
+std::future<SearchResult> startSearch(const CheckersBoard& position, SearchLimits limits, std::stop_token stop) {
+    return std::async(std::launch::async,
+        [board = position, limits = std::move(limits), stop = std::move(stop)]() mutable {
+            // Поиск опрашивает атомарный флаг; запрос остановки поднимает его
+            // (сразу же, если остановка запрошена до старта)
+            std::atomic<bool> stopFlag{ false };
+            std::stop_callback onStop(stop, [&stopFlag]() { stopFlag.store(true); });
+            limits.stop = &stopFlag;
+            return board.search(limits);
+        });
+}
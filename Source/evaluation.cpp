@@ -0,0 +1,75 @@
+﻿#include "../Include/evaluation.h"
+#include "../Include/eval_lanes.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace {
+
+// AVX2 есть и у процессора, и у ОС (сохраняет регистры YMM)
+bool cpuHasAvx2() {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+bool Evaluation::useAvx2() {
+    static const bool available = avx2Width() > 0 && cpuHasAvx2();
+    return available;
+}
+
+int Evaluation::squareScore(uint32_t white, uint32_t black, uint32_t kings) {
+    return static_cast<int>(squareLanes<ScalarLanes>(white, black, kings));
+}
+
+int Evaluation::mobilityScore(uint32_t white, uint32_t black, uint32_t kings) {
+    return static_cast<int>(mobilityLanes<ScalarLanes>(white, black, kings));
+}
+
+int Evaluation::evaluate(uint32_t white, uint32_t black, uint32_t kings) {
+    return static_cast<int>(evaluateLanes<ScalarLanes>(white, black, kings));
+}
+
+void Evaluation::evaluateBatch(const EvalPosition* positions, int* scores, size_t count) {
+    size_t done = 0;
+    if (useAvx2()) {
+        done = evaluateBatchAvx2(positions, scores, count);
+    }
+#ifdef EVAL_HAS_SSE2
+    done += evaluateBatchLanes<Sse2Lanes>(positions + done, scores + done, count - done);
+#endif
+    // Хвост, не заполняющий вектор
+    for (; done < count; ++done) {
+        scores[done] = evaluate(positions[done].white, positions[done].black, positions[done].kings);
+    }
+}
+
+const char* Evaluation::instructionSet() {
+    if (useAvx2()) {
+        return "AVX2";
+    }
+#ifdef EVAL_HAS_SSE2
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
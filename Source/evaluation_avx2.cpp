@@ -0,0 +1,24 @@
+﻿#include "../Include/evaluation.h"
+#include "../Include/eval_lanes.h"
+
+// Единица трансляции собирается с -mavx2 (/arch:AVX2), но вызывается только
+// после проверки процессора в evaluation.cpp. Без AVX2 при сборке — пустышка.
+
+size_t Evaluation::avx2Width() {
+#ifdef EVAL_HAS_AVX2
+    return Avx2Lanes::WIDTH;
+#else
+    return 0;
+#endif
+}
+
+size_t Evaluation::evaluateBatchAvx2(const EvalPosition* positions, int* scores, size_t count) {
+#ifdef EVAL_HAS_AVX2
+    return evaluateBatchLanes<Avx2Lanes>(positions, scores, count);
+#else
+    (void)positions;
+    (void)scores;
+    (void)count;
+    return 0;
+#endif
+}
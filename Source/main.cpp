@@ -1,8 +1,52 @@
 ﻿#include "../Include/checkers.h"
+#include "../Include/mcts.h"
+#include "../Include/ponder.h"
+#include <fstream>
+#include <memory>
 
-int main() {
+// task1 [--stats файл] [--mcts]
+//   --stats  после каждого поиска компьютера дописывать в файл строку JSON
+//            с ходом, оценкой и статистикой поиска
+//   --mcts   компьютер ищет поиском Монте-Карло вместо альфа-беты
+int main(int argc, char* argv[]) {
     setlocale(LC_ALL, "ru");
 
+    std::ofstream statsFile;
+    bool useMcts = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stats" && i + 1 < argc) {
+            statsFile.open(argv[++i], std::ios::app);
+            if (!statsFile) {
+                std::cout << "Не удалось открыть " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if (arg == "--mcts") {
+            useMcts = true;
+        }
+        else {
+            std::cout << "Использование: task1 [--stats файл] [--mcts]\n";
+            return 1;
+        }
+    }
+
+    // Размер таблицы транспозиций задаётся один раз при старте
+    TranspositionTable::shared().resize(64);
+    // Таблицы окончаний из каталога tb, если они построены (программа tbgen)
+    Tablebases::shared().load("tb");
+    // Дебютная книга, если она построена (программа bookgen)
+    OpeningBook::shared().load("book.bin");
+    // Дерево Монте-Карло живёт всю партию: между ходами поддерево переиспользуется
+    std::unique_ptr<MonteCarloTree> tree;
+    if (useMcts) {
+        tree = std::make_unique<MonteCarloTree>(256);
+    }
+
+    // Время на ход компьютера; пока ходит человек, компьютер думает в фоне
+    const std::chrono::milliseconds aiBudget(1000);
+    Ponder ponder(aiBudget);
+
     std::cout << "Добро пожаловать в игру \"Классические шашки\"!\n";
     std::cout << "Выберите, за кого хотите играть (W - белые, B - чёрные): ";
 
@@ -10,10 +54,14 @@ int main() {
     std::cin >> side;
     side = std::toupper(side);
     CheckersBoard board;
+    if (statsFile.is_open()) {
+        board.setStatsOutput(&statsFile);
+    }
+    board.setMonteCarloTree(tree.get());
     bool userIsWhite = (side == 'W');
     board.setWhiteToMove(true);
     if (!userIsWhite) {
-        Move aiMove = board.getBestMove(5); // глубина = 5
+        Move aiMove = ponder.think(board);
         if (aiMove.size() > 0) {
             board.makeMove(aiMove);
         }
@@ -38,9 +86,9 @@ int main() {
 
         bool curIsWhite = board.isWhiteToMove();
         if ((curIsWhite && userIsWhite) || (!curIsWhite && !userIsWhite)) {
-            std::vector<Move> allMoves = board.getAllPossibleMoves(curIsWhite);
+            MoveList allMoves = board.getAllPossibleMoves(curIsWhite);
 
-            std::vector<Move> mandatoryMoves;
+            MoveList mandatoryMoves;
             for (const auto& mv : allMoves) {
                 if (mv.size() > 2) {
                     mandatoryMoves.push_back(mv);
@@ -48,7 +96,10 @@ int main() {
             }
 
             bool hasMandatoryMoves = !mandatoryMoves.empty();
-            const std::vector<Move>& validMoves = hasMandatoryMoves ? mandatoryMoves : allMoves;
+            const MoveList& validMoves = hasMandatoryMoves ? mandatoryMoves : allMoves;
+
+            // Фоновый поиск на время ввода
+            ponder.start(board);
 
             while (true) {
                 std::cout << "Ваш ход (формат B3 A4): ";
@@ -66,7 +117,7 @@ int main() {
                 // Проверяем, что ход есть в списке validMoves
                 bool isValidMove = false;
                 for (const auto& mv : validMoves) {
-                    if (mv.path == userMove.path) {
+                    if (mv == userMove) {
                         isValidMove = true;
                         break;
                     }
@@ -86,7 +137,10 @@ int main() {
         else {
             // Ход компьютера
             std::cout << "Ход Компьютера...\n";
-            Move aiMove = board.getBestMove(5);
+            Move aiMove = ponder.think(board);
+            if (ponder.lastWasHit()) {
+                std::cout << "Ваш ход был предугадан, ответ готов.\n";
+            }
             if (aiMove.size() == 0) {
                 std::cout << "Компьютер не может ходить... Похоже, игра заканчивается.\n";
                 break;
@@ -0,0 +1,378 @@
+﻿#include "../Include/checkers.h"
+#include "../Include/mcts.h"
+#include "../Include/thread_pool.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+
+// match: партии движка против движка для проверки, не ослаб ли он.
+//
+//   match [-n партий] [-s зерно] [-p полуходов] [-a движок] [-b движок] [-H МБ]
+//         [-e0 Elo] [-e1 Elo] [-alpha a] [-beta b] [-r каждые N]
+//     -n  число партий (по умолчанию 1000; округляется до чётного)
+//     -s  зерно дебютов (по умолчанию 1)
+//     -p  случайных полуходов дебюта (по умолчанию 4)
+//     -a, -b  настройки движков A и B: "depth=6,time=100,eval=full|nomobility,select=on|off,
+//             engine=ab|mcts,playouts=N,policy=puct|uct" (time — мс на ход, 0 — только
+//             по глубине или розыгрышам; select — выборочный поиск; engine — альфа-бета
+//             или поиск Монте-Карло; для mcts: playouts — розыгрышей на ход, 0 — по времени,
+//             policy — правило выбора хода в дереве;
+//             по умолчанию depth=6, eval=full, select=on, engine=ab, policy=puct)
+//     -H  таблица транспозиций (для mcts — дерево) каждого движка в каждом потоке (по умолчанию 4 МБ)
+//     -e0, -e1, -alpha, -beta  SPRT: H0 — A сильнее на e0 Elo, H1 — на e1
+//             (по умолчанию 0 и 5, ошибки 0.05); по решению SPRT матч останавливается
+//     -r  печатать промежуточный итог каждые N партий (по умолчанию 100)
+//
+// Каждый дебют (случайные ходы от начальной позиции по зерну) играется дважды
+// со сменой цвета. Партии идут параллельно в общем пуле, у каждого потока
+// свои таблицы транспозиций для A и B. Ничья — 300 полуходов или 60 полуходов
+// без рубок и ходов простыми. Результаты — с точки зрения A.
+
+namespace {
+
+const int MAX_GAME_PLIES = 300;
+const int NO_PROGRESS_PLIES = 60;
+
+struct EngineConfig {
+    int depth = 6;
+    std::chrono::milliseconds budget{ 0 };
+    EvalVariant eval = EvalVariant::FULL;
+    bool selective = true;
+    bool mcts = false;
+    uint64_t playouts = 0;
+    bool puct = true;
+
+    std::string describe() const {
+        std::ostringstream out;
+        if (mcts) {
+            out << "engine=mcts,playouts=" << playouts << ",policy=" << (puct ? "puct" : "uct")
+                << ",time=" << budget.count() << ",eval="
+                << (eval == EvalVariant::FULL ? "full" : "nomobility");
+            return out.str();
+        }
+        out << "depth=" << depth << ",time=" << budget.count() << ",eval="
+            << (eval == EvalVariant::FULL ? "full" : "nomobility")
+            << ",select=" << (selective ? "on" : "off");
+        return out.str();
+    }
+};
+
+bool parseEngine(const std::string& text, EngineConfig& config) {
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            return false;
+        }
+        std::string key = item.substr(0, eq);
+        std::string value = item.substr(eq + 1);
+        if (key == "depth") {
+            config.depth = std::atoi(value.c_str());
+        }
+        else if (key == "time") {
+            config.budget = std::chrono::milliseconds(std::atol(value.c_str()));
+        }
+        else if (key == "eval" && (value == "full" || value == "nomobility")) {
+            config.eval = value == "full" ? EvalVariant::FULL : EvalVariant::NO_MOBILITY;
+        }
+        else if (key == "select" && (value == "on" || value == "off")) {
+            config.selective = value == "on";
+        }
+        else if (key == "engine" && (value == "ab" || value == "mcts")) {
+            config.mcts = value == "mcts";
+        }
+        else if (key == "playouts") {
+            config.playouts = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (key == "policy" && (value == "puct" || value == "uct")) {
+            config.puct = value == "puct";
+        }
+        else {
+            return false;
+        }
+    }
+    return config.depth >= 1;
+}
+
+// Таблицы (и деревья Монте-Карло) движков A и B потока пула; очищаются перед каждой партией
+struct Worker {
+    TranspositionTable tables[2];
+    std::unique_ptr<MonteCarloTree> trees[2];
+
+    Worker(size_t hashMb, const EngineConfig configs[2])
+        : tables{ TranspositionTable(hashMb), TranspositionTable(hashMb) }
+    {
+        for (int i = 0; i < 2; ++i) {
+            if (configs[i].mcts) {
+                trees[i] = std::make_unique<MonteCarloTree>(hashMb);
+                MctsOptions options;
+                options.playouts = configs[i].playouts;
+                options.puct = configs[i].puct;
+                trees[i]->setOptions(options);
+            }
+        }
+    }
+};
+
+// Дебют: plies случайных ходов; позиции, где игра уже кончилась, отбрасываются
+CheckersBoard makeOpening(uint64_t seed, int plies) {
+    std::mt19937_64 rng(seed);
+    while (true) {
+        CheckersBoard board;
+        board.setWhiteToMove(true);
+        int ply = 0;
+        for (; ply < plies && board.canCurrentPlayerMove(); ++ply) {
+            MoveList moves = board.getAllPossibleMoves(board.isWhiteToMove());
+            board.makeMoveUnchecked(moves[rng() % moves.size()]);
+        }
+        if (ply == plies && board.canCurrentPlayerMove()) {
+            return board;
+        }
+    }
+}
+
+// Очки A: 2 — победа, 1 — ничья, 0 — поражение
+int playGame(CheckersBoard board, bool aIsWhite, const EngineConfig configs[2], Worker& worker) {
+    for (int i = 0; i < 2; ++i) {
+        worker.tables[i].clear();
+        if (worker.trees[i]) {
+            worker.trees[i]->clear();
+        }
+    }
+    board.setOpeningBook(nullptr);
+
+    int quietPlies = 0;
+    for (int ply = 0; ply < MAX_GAME_PLIES && quietPlies < NO_PROGRESS_PLIES; ++ply) {
+        bool aToMove = board.isWhiteToMove() == aIsWhite;
+        if (!board.canCurrentPlayerMove()) {
+            return aToMove ? 0 : 2;
+        }
+        const EngineConfig& config = configs[aToMove ? 0 : 1];
+        board.setTranspositionTable(&worker.tables[aToMove ? 0 : 1]);
+        board.setMonteCarloTree(worker.trees[aToMove ? 0 : 1].get());
+        board.setEvalVariant(config.eval);
+        board.setSearchOptions(config.selective ? SearchOptions() : SearchOptions::fullWidth());
+
+        SearchLimits limits;
+        limits.depth = config.depth;
+        limits.budget = config.budget;
+        limits.threads = 1;
+        Move move = board.search(limits).bestMove;
+
+        // Рубка или ход простой — необратимы, счёт полуходов без изменений сбрасывается
+        bool progress = move.captured != 0 || !(board.kingPieces() & (1u << move.fromSquare()));
+        quietPlies = progress ? 0 : quietPlies + 1;
+        board.makeMove(move);
+    }
+    return 1;
+}
+
+double expectedScore(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+double eloFromScore(double score) {
+    score = std::clamp(score, 1e-6, 1.0 - 1e-6);
+    return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+struct MatchStats {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int games() const { return wins + draws + losses; }
+    double score() const { return games() ? (wins + 0.5 * draws) / games() : 0.5; }
+
+    // Дисперсия очков за партию
+    double variance() const {
+        if (games() == 0) {
+            return 0.0;
+        }
+        double s = score();
+        return (wins * (1.0 - s) * (1.0 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games();
+    }
+
+    // Elo и полуширина 95% интервала
+    void elo(double& value, double& margin) const {
+        value = eloFromScore(score());
+        double se = std::sqrt(variance() / std::max(1, games()));
+        margin = (eloFromScore(score() + 1.96 * se) - eloFromScore(score() - 1.96 * se)) / 2.0;
+    }
+
+    // Логарифм отношения правдоподобия H1/H0 в нормальном приближении
+    double llr(double elo0, double elo1) const {
+        double var = variance();
+        if (games() == 0 || var <= 0.0) {
+            return 0.0;
+        }
+        double s0 = expectedScore(elo0);
+        double s1 = expectedScore(elo1);
+        return games() * (s1 - s0) * (2.0 * score() - s0 - s1) / (2.0 * var);
+    }
+};
+
+struct SprtSettings {
+    double elo0 = 0.0;
+    double elo1 = 5.0;
+    double alpha = 0.05;
+    double beta = 0.05;
+
+    double lower() const { return std::log(beta / (1.0 - alpha)); }
+    double upper() const { return std::log((1.0 - beta) / alpha); }
+};
+
+void printStats(const MatchStats& stats, const SprtSettings& sprt, double seconds) {
+    double elo, margin;
+    stats.elo(elo, margin);
+    std::cout << "Партий: " << stats.games()
+        << "  +" << stats.wins << " =" << stats.draws << " -" << stats.losses
+        << std::fixed << std::setprecision(1)
+        << "  Elo: " << elo << " +/- " << margin
+        << std::setprecision(2)
+        << "  LLR: " << stats.llr(sprt.elo0, sprt.elo1)
+        << " [" << sprt.lower() << ", " << sprt.upper() << "]"
+        << std::setprecision(1)
+        << "  партий/мин: " << (seconds > 0 ? stats.games() * 60.0 / seconds : 0.0) << "\n";
+    std::cout.unsetf(std::ios::fixed);
+}
+
+void printUsage() {
+    std::cout << "Использование: match [-n партий] [-s зерно] [-p полуходов] [-a движок] [-b движок] [-H МБ]\n"
+        << "                     [-e0 Elo] [-e1 Elo] [-alpha a] [-beta b] [-r каждые N]\n"
+        << "  движок: depth=6,time=100,eval=full|nomobility,select=on|off,engine=ab|mcts,playouts=N,policy=puct|uct\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    setlocale(LC_ALL, "ru");
+
+    int games = 1000;
+    uint64_t seed = 1;
+    int openingPlies = 4;
+    size_t hashMb = 4;
+    int reportEvery = 100;
+    EngineConfig configs[2];
+    SprtSettings sprt;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-n" && hasValue) {
+            games = std::atoi(argv[++i]);
+        }
+        else if (arg == "-s" && hasValue) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-p" && hasValue) {
+            openingPlies = std::atoi(argv[++i]);
+        }
+        else if ((arg == "-a" || arg == "-b") && hasValue) {
+            if (!parseEngine(argv[++i], configs[arg == "-a" ? 0 : 1])) {
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "-H" && hasValue) {
+            hashMb = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-e0" && hasValue) {
+            sprt.elo0 = std::atof(argv[++i]);
+        }
+        else if (arg == "-e1" && hasValue) {
+            sprt.elo1 = std::atof(argv[++i]);
+        }
+        else if (arg == "-alpha" && hasValue) {
+            sprt.alpha = std::atof(argv[++i]);
+        }
+        else if (arg == "-beta" && hasValue) {
+            sprt.beta = std::atof(argv[++i]);
+        }
+        else if (arg == "-r" && hasValue) {
+            reportEvery = std::atoi(argv[++i]);
+        }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (games < 2 || openingPlies < 0 || hashMb == 0 || reportEvery < 1 ||
+        sprt.alpha <= 0.0 || sprt.alpha >= 1.0 || sprt.beta <= 0.0 || sprt.beta >= 1.0 ||
+        sprt.elo1 <= sprt.elo0)
+    {
+        printUsage();
+        return 1;
+    }
+    games += games % 2;
+
+    // Дебютная книга не нужна, общая таблица тоже: у движков свои
+    TranspositionTable::shared().resize(1);
+    Tablebases::shared().load("tb");
+
+    std::cout << "A: " << configs[0].describe() << "\n";
+    std::cout << "B: " << configs[1].describe() << "\n";
+
+    ThreadPool& pool = ThreadPool::instance();
+    std::mutex statsMutex;
+    MatchStats stats;
+    std::atomic<bool> finished{ false };
+    int verdict = 0;  // 1 — принята H1, -1 — H0
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&start]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    TaskGroup group(pool);
+    for (int pair = 0; pair < games / 2; ++pair) {
+        for (int colour = 0; colour < 2; ++colour) {
+            group.run([&, pair, colour]() {
+                if (finished.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                thread_local std::unique_ptr<Worker> worker;
+                if (!worker) {
+                    worker = std::make_unique<Worker>(hashMb, configs);
+                }
+                CheckersBoard opening = makeOpening(seed * 0x9E3779B97F4A7C15ull + pair, openingPlies);
+                int points = playGame(opening, colour == 0, configs, *worker);
+
+                std::lock_guard<std::mutex> lock(statsMutex);
+                if (finished.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                stats.wins += points == 2;
+                stats.draws += points == 1;
+                stats.losses += points == 0;
+                double llr = stats.llr(sprt.elo0, sprt.elo1);
+                if (llr >= sprt.upper() || llr <= sprt.lower()) {
+                    verdict = llr >= sprt.upper() ? 1 : -1;
+                    finished.store(true);
+                }
+                if (stats.games() % reportEvery == 0) {
+                    printStats(stats, sprt, elapsed());
+                }
+            });
+        }
+    }
+    group.wait();
+
+    std::cout << "Итог:\n";
+    printStats(stats, sprt, elapsed());
+    if (verdict > 0) {
+        std::cout << "SPRT: принята H1 — A сильнее B не меньше чем на " << sprt.elo1 << " Elo\n";
+    }
+    else if (verdict < 0) {
+        std::cout << "SPRT: принята H0 — A сильнее B не больше чем на " << sprt.elo0 << " Elo\n";
+    }
+    else {
+        std::cout << "SPRT: решения нет, нужно больше партий\n";
+    }
+    return 0;
+}
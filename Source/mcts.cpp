@@ -0,0 +1,462 @@
+﻿#include "../Include/mcts.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "../Include/thread_pool.h"
+
+namespace {
+
+// Результат розыгрыша — в тысячных долях очка
+const double REWARD_SCALE = 1000.0;
+// Оценка позиции в конце розыгрыша переводится в ожидаемое очко
+// логистой 1 / (1 + e^(-eval / EVAL_SCALE)): перевес в две простые — около 73%
+const double EVAL_SCALE = 200.0;
+// Температура априорных вероятностей PUCT: разница оценок ходов в одну простую
+// меняет вероятность в e раз
+const double PRIOR_TEMPERATURE = 100.0;
+// Глубже этого спуск по дереву не идёт, дальше — розыгрыш
+const int MAX_TREE_DEPTH = 128;
+const int MAX_PV = 32;
+// Как часто поток проверяет время (в розыгрышах)
+const uint64_t CLOCK_INTERVAL = 64;
+// Как часто основной поток сообщает промежуточный итог (в розыгрышах)
+const uint64_t PROGRESS_INTERVAL = 4096;
+
+// Ожидаемое очко стороны хода по её оценке, и обратно
+double scoreToExpectation(int eval) {
+    return 1.0 / (1.0 + std::exp(-eval / EVAL_SCALE));
+}
+
+int expectationToScore(double q) {
+    q = std::clamp(q, 0.001, 0.999);
+    return static_cast<int>(std::lround(EVAL_SCALE * std::log(q / (1.0 - q))));
+}
+
+bool samePosition(const CheckersBoard& a, const CheckersBoard& b) {
+    return a.whitePieces() == b.whitePieces() && a.blackPieces() == b.blackPieces() &&
+        a.kingPieces() == b.kingPieces() && a.isWhiteToMove() == b.isWhiteToMove();
+}
+
+} // namespace
+
+// Поток поиска: своя копия доски в позиции корня и свой генератор случайных чисел
+struct MonteCarloTree::Worker {
+    CheckersBoard board;
+    uint64_t rng;
+    int maxDepth = 0;
+    std::vector<uint32_t> path;
+    std::vector<Undo> undos;
+
+    Worker(const CheckersBoard& position, int id) : board(position) {
+        // Зерно от позиции и номера потока: однопоточный поиск воспроизводим
+        rng = position.hash() ^ (0x9E3779B97F4A7C15ull * (id + 1));
+        path.reserve(MAX_TREE_DEPTH + 1);
+        undos.reserve(MAX_TREE_DEPTH);
+    }
+
+    // xorshift64*
+    uint64_t random() {
+        rng ^= rng >> 12;
+        rng ^= rng << 25;
+        rng ^= rng >> 27;
+        return rng * 0x2545F4914F6CDD1Dull;
+    }
+};
+
+MonteCarloTree::MonteCarloTree(size_t megabytes) {
+    resize(megabytes);
+}
+
+void MonteCarloTree::resize(size_t megabytes) {
+    nodeCount = std::max<size_t>(1, megabytes * 1024 * 1024 / sizeof(Node));
+    nodes.reset(new Node[nodeCount]);
+    clear();
+}
+
+void MonteCarloTree::clear() {
+    next.store(0, std::memory_order_relaxed);
+    root = 0;
+}
+
+size_t MonteCarloTree::used() const {
+    return next.load(std::memory_order_relaxed);
+}
+
+void MonteCarloTree::resetNode(Node& node, const Move& move) {
+    node.move = move;
+    node.visits.store(0, std::memory_order_relaxed);
+    node.virtualLoss.store(0, std::memory_order_relaxed);
+    node.reward.store(0, std::memory_order_relaxed);
+    node.state.store(NEW, std::memory_order_relaxed);
+    node.childCount = 0;
+    node.firstChild = 0;
+    node.prior = 0.0f;
+}
+
+// Новое дерево из одного корня
+void MonteCarloTree::reset(const CheckersBoard& board) {
+    next.store(1, std::memory_order_relaxed);
+    root = 0;
+    resetNode(nodes[0], Move());
+    rootWhite = board.whitePieces();
+    rootBlack = board.blackPieces();
+    rootKings = board.kingPieces();
+    rootWhiteToMove = board.isWhiteToMove();
+}
+
+// Новый корень среди узлов прошлого дерева на глубине 0..2.
+// Занятая больше чем наполовину область не переиспользуется: поддереву
+// нужно место для роста, а освободить остальные узлы нельзя.
+bool MonteCarloTree::reuseSubtree(const CheckersBoard& board) {
+    if (next.load(std::memory_order_relaxed) == 0 || used() > nodeCount / 2) {
+        return false;
+    }
+    CheckersBoard replay = board;
+    replay.setPosition(rootWhite, rootBlack, rootKings, rootWhiteToMove);
+    uint32_t found = UINT32_MAX;
+    if (samePosition(replay, board)) {
+        found = root;
+    }
+    const Node& top = nodes[root];
+    if (found == UINT32_MAX && top.state.load(std::memory_order_acquire) == EXPANDED) {
+        for (uint32_t c = top.firstChild; c < top.firstChild + top.childCount && found == UINT32_MAX; ++c) {
+            const Node& child = nodes[c];
+            Undo u = replay.makeMoveUnchecked(child.move);
+            if (samePosition(replay, board)) {
+                found = c;
+            }
+            else if (child.state.load(std::memory_order_acquire) == EXPANDED) {
+                for (uint32_t g = child.firstChild; g < child.firstChild + child.childCount; ++g) {
+                    Undo ug = replay.makeMoveUnchecked(nodes[g].move);
+                    bool same = samePosition(replay, board);
+                    replay.unmakeMove(ug);
+                    if (same) {
+                        found = g;
+                        break;
+                    }
+                }
+            }
+            replay.unmakeMove(u);
+        }
+    }
+    if (found == UINT32_MAX) {
+        return false;
+    }
+    root = found;
+    rootWhite = board.whitePieces();
+    rootBlack = board.blackPieces();
+    rootKings = board.kingPieces();
+    rootWhiteToMove = board.isWhiteToMove();
+    return true;
+}
+
+// Раскрытие узла (вызывает поток, переведший его в EXPANDING): дети —
+// ходы генератора подряд в области узлов. Без ходов узел — конец партии;
+// если место кончилось, узел остаётся нераскрытым. Место занимается только
+// целиком (next не растёт за nodeCount), а в заполненной области ходы
+// не генерируются вовсе: дальше узлы лишь разыгрываются.
+bool MonteCarloTree::expand(Node& node, CheckersBoard& board) {
+    if (next.load(std::memory_order_relaxed) >= nodeCount) {
+        node.state.store(NEW, std::memory_order_release);
+        return false;
+    }
+    MoveList moves = board.getAllPossibleMoves(board.isWhiteToMove());
+    if (moves.empty()) {
+        node.state.store(TERMINAL, std::memory_order_release);
+        return false;
+    }
+    size_t first = next.load(std::memory_order_relaxed);
+    do {
+        if (first + moves.size() > nodeCount) {
+            node.state.store(NEW, std::memory_order_release);
+            return false;
+        }
+    } while (!next.compare_exchange_weak(first, first + moves.size(), std::memory_order_relaxed));
+
+    // Априорные вероятности PUCT: softmax оценок позиций после хода
+    // с точки зрения ходящего
+    MoveBuffer<double> priors(moves.size());
+    double total = 0.0;
+    if (options.puct) {
+        MoveBuffer<int> evals(moves.size());
+        int best = std::numeric_limits<int>::min();
+        for (size_t i = 0; i < moves.size(); ++i) {
+            Undo u = board.makeMoveUnchecked(moves[i]);
+            evals[i] = board.isWhiteToMove() ? -board.evaluateBoard() : board.evaluateBoard();
+            board.unmakeMove(u);
+            best = std::max(best, evals[i]);
+        }
+        for (size_t i = 0; i < moves.size(); ++i) {
+            priors[i] = std::exp((evals[i] - best) / PRIOR_TEMPERATURE);
+            total += priors[i];
+        }
+    }
+    for (size_t i = 0; i < moves.size(); ++i) {
+        Node& child = nodes[first + i];
+        resetNode(child, moves[i]);
+        child.prior = static_cast<float>(options.puct ? priors[i] / total : 1.0 / moves.size());
+    }
+    node.firstChild = static_cast<uint32_t>(first);
+    node.childCount = static_cast<uint16_t>(moves.size());
+    node.state.store(EXPANDED, std::memory_order_release);
+    return true;
+}
+
+// Выбор ребёнка по UCT или PUCT. Виртуальные поражения считаются
+// посещениями без награды.
+uint32_t MonteCarloTree::selectChild(const Node& node) const {
+    double parentVisits = std::max<double>(1.0, node.visits.load(std::memory_order_relaxed) +
+        node.virtualLoss.load(std::memory_order_relaxed));
+    // Ценность ещё не посещённого хода в PUCT — ценность родителя для ходящего
+    double parentValue = 0.5;
+    if (node.visits.load(std::memory_order_relaxed) > 0) {
+        parentValue = 1.0 - node.reward.load(std::memory_order_relaxed) / REWARD_SCALE /
+            node.visits.load(std::memory_order_relaxed);
+    }
+    double logParent = std::log(parentVisits);
+    double sqrtParent = std::sqrt(parentVisits);
+
+    uint32_t best = node.firstChild;
+    double bestValue = -1.0;
+    for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; ++c) {
+        const Node& child = nodes[c];
+        double n = child.visits.load(std::memory_order_relaxed) +
+            child.virtualLoss.load(std::memory_order_relaxed);
+        double w = child.reward.load(std::memory_order_relaxed) / REWARD_SCALE;
+        double value;
+        if (options.puct) {
+            double q = n > 0 ? w / n : parentValue;
+            value = q + options.exploration * child.prior * sqrtParent / (1.0 + n);
+        }
+        else {
+            if (n == 0) {
+                return c;
+            }
+            value = w / n + options.exploration * std::sqrt(logParent / n);
+        }
+        if (value > bestValue) {
+            bestValue = value;
+            best = c;
+        }
+    }
+    return best;
+}
+
+// Случайная партия из позиции доски не длиннее rolloutPlies полуходов.
+// Возвращает ожидаемое очко стороны хода в исходной позиции.
+double MonteCarloTree::rollout(Worker& worker) {
+    CheckersBoard& board = worker.board;
+    const Tablebases* tb = board.tablebases();
+    Undo undos[256];
+    int plies = std::min(options.rolloutPlies, 256);
+    int ply = 0;
+    double value = -1.0;  // для стороны хода после ply полуходов
+    for (; ply < plies; ++ply) {
+        TBEntry entry;
+        if (std::popcount(board.whitePieces() | board.blackPieces()) <= tb->maxPieces() &&
+            tb->probe(board.whitePieces(), board.blackPieces(), board.kingPieces(), board.isWhiteToMove(), entry))
+        {
+            value = entry.wdl == WDL::WIN ? 1.0 : entry.wdl == WDL::LOSS ? 0.0 : 0.5;
+            break;
+        }
+        MoveList moves = board.getAllPossibleMoves(board.isWhiteToMove());
+        if (moves.empty()) {
+            value = 0.0;
+            break;
+        }
+        undos[ply] = board.makeMoveUnchecked(moves[worker.random() % moves.size()]);
+    }
+    if (value < 0.0) {
+        int eval = board.evaluateBoard();
+        value = scoreToExpectation(board.isWhiteToMove() ? eval : -eval);
+    }
+    if (ply % 2 != 0) {
+        value = 1.0 - value;
+    }
+    while (ply > 0) {
+        board.unmakeMove(undos[--ply]);
+    }
+    return value;
+}
+
+// Одна итерация: спуск с виртуальными поражениями, раскрытие, розыгрыш, обратный проход
+void MonteCarloTree::playout(Worker& worker) {
+    CheckersBoard& board = worker.board;
+    worker.path.clear();
+    worker.undos.clear();
+    worker.path.push_back(root);
+
+    double value;  // ожидаемое очко стороны хода в листе
+    while (true) {
+        Node& node = nodes[worker.path.back()];
+        uint8_t state = node.state.load(std::memory_order_acquire);
+        if (state == EXPANDED && static_cast<int>(worker.undos.size()) < MAX_TREE_DEPTH) {
+            uint32_t c = selectChild(node);
+            nodes[c].virtualLoss.fetch_add(options.virtualLoss, std::memory_order_relaxed);
+            worker.undos.push_back(board.makeMoveUnchecked(nodes[c].move));
+            worker.path.push_back(c);
+            continue;
+        }
+        if (state == TERMINAL) {
+            value = 0.0;
+            break;
+        }
+        if (state == NEW && node.state.compare_exchange_strong(state, EXPANDING, std::memory_order_acq_rel) &&
+            !expand(node, board) && node.state.load(std::memory_order_relaxed) == TERMINAL)
+        {
+            value = 0.0;
+            break;
+        }
+        // Раскрытый только что, раскрываемый другим потоком или слишком глубокий узел
+        value = rollout(worker);
+        break;
+    }
+    worker.maxDepth = std::max(worker.maxDepth, static_cast<int>(worker.undos.size()));
+
+    // Награда узла — для стороны, сделавшей ведущий в него ход
+    double reward = 1.0 - value;
+    for (size_t i = worker.path.size(); i-- > 0;) {
+        Node& node = nodes[worker.path[i]];
+        node.reward.fetch_add(static_cast<uint64_t>(std::lround(reward * REWARD_SCALE)), std::memory_order_relaxed);
+        node.visits.fetch_add(1, std::memory_order_relaxed);
+        if (i > 0) {
+            node.virtualLoss.fetch_sub(options.virtualLoss, std::memory_order_relaxed);
+        }
+        reward = 1.0 - reward;
+    }
+    for (auto it = worker.undos.rbegin(); it != worker.undos.rend(); ++it) {
+        board.unmakeMove(*it);
+    }
+}
+
+// Главный вариант — по самым посещаемым детям, начиная с корня;
+// ход и оценка — по первому из них
+void MonteCarloTree::principalVariation(bool whiteToMove, SearchResult& result) const {
+    result.pv.clear();
+    const Node* node = &nodes[root];
+    while (node->state.load(std::memory_order_acquire) == EXPANDED &&
+        static_cast<int>(result.pv.size()) < MAX_PV)
+    {
+        const Node* best = nullptr;
+        for (uint32_t c = node->firstChild; c < node->firstChild + node->childCount; ++c) {
+            const Node& child = nodes[c];
+            if (!best || child.visits > best->visits ||
+                (child.visits == best->visits && child.reward > best->reward))
+            {
+                best = &child;
+            }
+        }
+        if (result.pv.empty()) {
+            result.bestMove = best->move;
+            uint32_t visits = best->visits.load();
+            double q = visits ? best->reward.load() / REWARD_SCALE / visits : 0.5;
+            int score = expectationToScore(q);
+            result.score = whiteToMove ? score : -score;
+        }
+        else if (best->visits == 0) {
+            break;
+        }
+        result.pv.push_back(best->move);
+        node = best;
+    }
+}
+
+// Поиск: корень раскрывается до запуска потоков, затем основной поток
+// и помощники из общего пула разыгрывают партии, пока не выйдет время,
+// предел розыгрышей или не поднят флаг остановки. Ход — самый посещаемый.
+SearchResult MonteCarloTree::search(const CheckersBoard& board, const SearchLimits& limits) {
+    SearchResult result;
+    CheckersBoard position = board;
+    MoveList moves = position.getAllPossibleMoves(position.isWhiteToMove());
+    if (moves.empty()) {
+        return result;
+    }
+    result.bestMove = moves[0];
+
+    if (!reuseSubtree(board)) {
+        reset(board);
+    }
+    Node& top = nodes[root];
+    uint8_t state = NEW;
+    if (top.state.compare_exchange_strong(state, EXPANDING)) {
+        expand(top, position);
+    }
+
+    // Свой флаг останавливает помощников; внешний (limits.stop) может быть
+    // общим для нескольких поисков, поэтому он только читается
+    std::atomic<bool> stop{ false };
+    auto stopped = [&stop, external = limits.stop]() {
+        if (external && external->load(std::memory_order_relaxed)) {
+            stop.store(true, std::memory_order_relaxed);
+        }
+        return stop.load(std::memory_order_relaxed);
+    };
+    auto deadline = std::chrono::steady_clock::now() + limits.budget;
+    bool timeLimited = limits.budget.count() > 0;
+    uint64_t limit = options.playouts;
+    if (limit == 0 && !timeLimited && !limits.stop) {
+        limit = DEFAULT_PLAYOUTS;
+    }
+    // Единственный ход искать незачем
+    bool single = top.state.load(std::memory_order_acquire) == EXPANDED && top.childCount == 1;
+
+    std::atomic<uint64_t> started{ 0 };
+    std::atomic<uint64_t> finished{ 0 };
+    std::atomic<int> maxDepth{ 0 };
+    auto searchStart = std::chrono::steady_clock::now();
+    auto work = [&](int id) {
+        Worker worker(board, id);
+        uint64_t done = 0;
+        while (!single && !stopped()) {
+            if (limit && started.fetch_add(1, std::memory_order_relaxed) >= limit) {
+                break;
+            }
+            playout(worker);
+            ++done;
+            if (timeLimited && done % CLOCK_INTERVAL == 0 && std::chrono::steady_clock::now() >= deadline) {
+                stop.store(true, std::memory_order_relaxed);
+            }
+            if (id == 0 && limits.progress && done % PROGRESS_INTERVAL == 0) {
+                SearchResult current;
+                principalVariation(board.isWhiteToMove(), current);
+                SearchProgress progress;
+                progress.bestMove = current.bestMove;
+                progress.depth = worker.maxDepth;
+                progress.score = current.score;
+                progress.nodes = done;
+                progress.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - searchStart).count();
+                progress.pv = std::move(current.pv);
+                limits.progress(progress);
+            }
+        }
+        finished.fetch_add(done, std::memory_order_relaxed);
+        int depth = maxDepth.load(std::memory_order_relaxed);
+        while (worker.maxDepth > depth && !maxDepth.compare_exchange_weak(depth, worker.maxDepth)) {
+        }
+    };
+
+    ThreadPool& pool = ThreadPool::instance();
+    int threads = limits.threads > 0 ? limits.threads : static_cast<int>(pool.fairShare());
+    {
+        TaskGroup helpers(pool);
+        for (int id = 1; id < threads; ++id) {
+            helpers.run([&work, id]() { work(id); });
+        }
+        work(0);
+        stop.store(true);
+        helpers.wait();
+    }
+
+    principalVariation(board.isWhiteToMove(), result);
+    // Без розыгрышей оценка — статическая, после единственного хода
+    if (single) {
+        Undo u = position.makeMoveUnchecked(result.bestMove);
+        result.score = position.evaluateBoard();
+        position.unmakeMove(u);
+    }
+    result.depth = maxDepth.load();
+    result.nodes = finished.load();
+    return result;
+}
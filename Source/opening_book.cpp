@@ -0,0 +1,82 @@
+﻿#include "../Include/opening_book.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+// Заголовок файла: "CBK2", 4 байта резерва, число записей (8 байт).
+// В "CBK1" номер хода был однобайтным — такие книги надо построить заново
+const char MAGIC[4] = { 'C', 'B', 'K', '2' };
+const size_t HEADER_SIZE = 16;
+
+bool entryLess(const BookEntry& a, const BookEntry& b) {
+    if (a.key != b.key) return a.key < b.key;
+    return a.moveIndex < b.moveIndex;
+}
+
+} // namespace
+
+bool OpeningBook::load(const std::string& path) {
+    entries = nullptr;
+    count = 0;
+    if (!file.open(path)) {
+        return false;
+    }
+    const uint8_t* bytes = file.data();
+    if (file.size() < HEADER_SIZE || std::memcmp(bytes, MAGIC, 4) != 0) {
+        file.close();
+        return false;
+    }
+    uint64_t n = 0;
+    std::memcpy(&n, bytes + 8, sizeof(n));
+    // Число записей из файла не умножается: испорченный заголовок переполнил бы произведение
+    if (n > (file.size() - HEADER_SIZE) / sizeof(BookEntry)) {
+        file.close();
+        return false;
+    }
+    // Отображение выровнено по странице, заголовок — 16 байт, записи выровнены
+    entries = reinterpret_cast<const BookEntry*>(bytes + HEADER_SIZE);
+    count = static_cast<size_t>(n);
+    return true;
+}
+
+void OpeningBook::find(uint64_t key, const BookEntry*& first, const BookEntry*& last) const {
+    auto byKey = [](const BookEntry& e, uint64_t k) { return e.key < k; };
+    first = std::lower_bound(entries, entries + count, key, byKey);
+    last = first;
+    while (last != entries + count && last->key == key) {
+        ++last;
+    }
+}
+
+bool OpeningBook::write(const std::string& path, std::vector<BookEntry> entries) {
+    std::sort(entries.begin(), entries.end(), entryLess);
+    std::vector<BookEntry> merged;
+    for (const auto& e : entries) {
+        if (!merged.empty() && merged.back().key == e.key && merged.back().moveIndex == e.moveIndex) {
+            merged.back().weight += e.weight;
+        }
+        else {
+            merged.push_back(e);
+        }
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    uint8_t header[HEADER_SIZE] = {};
+    std::memcpy(header, MAGIC, 4);
+    uint64_t n = merged.size();
+    std::memcpy(header + 8, &n, sizeof(n));
+    out.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+    out.write(reinterpret_cast<const char*>(merged.data()),
+        static_cast<std::streamsize>(merged.size() * sizeof(BookEntry)));
+    return static_cast<bool>(out);
+}
+
+OpeningBook& OpeningBook::shared() {
+    static OpeningBook book;
+    return book;
+}
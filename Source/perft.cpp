@@ -0,0 +1,193 @@
+﻿#include "../Include/checkers.h"
+#include "../Include/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+
+// perft: число листьев дерева ходов на глубину N.
+// Эталон корректности и скорости для getAllPossibleMoves / dfsCaptures / makeMove.
+//
+//   perft [-p "позиция"] [-d] [-H МБ] [-t потоки] глубина
+//     -p  позиция в записи CheckersBoard::parsePosition (по умолчанию начальная)
+//     -d  divide: число листьев отдельно для каждого хода из корня
+//     -H  хешированный perft с таблицей указанного размера
+//     -t  потоков для разбиения по ходам корня (0 — размер общего пула);
+//         одновременно считают не больше стольких ходов, но и не больше,
+//         чем потоков в пуле вместе с основным
+
+namespace {
+
+// Таблица уже посчитанных поддеревьев: (ключ, глубина) -> число листьев.
+// Как и таблица транспозиций, без блокировок: запись хранит key ^ count и count.
+class PerftTable {
+public:
+    explicit PerftTable(size_t megabytes) {
+        size_t want = megabytes * 1024 * 1024 / sizeof(Slot);
+        size = 1;
+        while (size * 2 <= want) {
+            size *= 2;
+        }
+        slots.reset(new Slot[size]);
+    }
+
+    bool probe(uint64_t key, int depth, uint64_t& count) const {
+        uint64_t k = salted(key, depth);
+        const Slot& s = slots[k & (size - 1)];
+        uint64_t c = s.count.load(std::memory_order_relaxed);
+        uint64_t x = s.keyXorCount.load(std::memory_order_relaxed);
+        if (c != 0 && (x ^ c) == k) {
+            count = c;
+            return true;
+        }
+        return false;
+    }
+
+    void store(uint64_t key, int depth, uint64_t count) {
+        uint64_t k = salted(key, depth);
+        Slot& s = slots[k & (size - 1)];
+        s.keyXorCount.store(k ^ count, std::memory_order_relaxed);
+        s.count.store(count, std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> keyXorCount{ 0 };
+        std::atomic<uint64_t> count{ 0 };
+    };
+    std::unique_ptr<Slot[]> slots;
+    size_t size;
+
+    static uint64_t salted(uint64_t key, int depth) {
+        return key ^ (0x9E3779B97F4A7C15ull * static_cast<uint64_t>(depth + 1));
+    }
+};
+
+uint64_t perft(CheckersBoard& board, int depth, PerftTable* table) {
+    if (depth == 0) {
+        return 1;
+    }
+    MoveList moves = board.getAllPossibleMoves(board.isWhiteToMove());
+    // Последний уровень считаем без makeMove
+    if (depth == 1) {
+        return moves.size();
+    }
+
+    uint64_t count = 0;
+    if (table && table->probe(board.hash(), depth, count)) {
+        return count;
+    }
+    for (const auto& mv : moves) {
+        Undo u = board.makeMoveUnchecked(mv);
+        count += perft(board, depth - 1, table);
+        board.unmakeMove(u);
+    }
+    if (table) {
+        table->store(board.hash(), depth, count);
+    }
+    return count;
+}
+
+void printUsage() {
+    std::cout << "Использование: perft [-p \"позиция\"] [-d] [-H МБ] [-t потоки] глубина\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    setlocale(LC_ALL, "ru");
+
+    std::string position;
+    bool divide = false;
+    size_t hashMb = 0;
+    int threads = 1;
+    int depth = -1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-p" && i + 1 < argc) {
+            position = argv[++i];
+        }
+        else if (arg == "-d") {
+            divide = true;
+        }
+        else if (arg == "-H" && i + 1 < argc) {
+            hashMb = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-t" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        }
+        else if (depth < 0 && !arg.empty() && std::isdigit(static_cast<unsigned char>(arg[0]))) {
+            depth = std::atoi(arg.c_str());
+        }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (depth < 1) {
+        printUsage();
+        return 1;
+    }
+
+    CheckersBoard board;
+    if (!position.empty() && !board.parsePosition(position)) {
+        std::cout << "Некорректная позиция: " << position << "\n";
+        return 1;
+    }
+
+    std::unique_ptr<PerftTable> table;
+    if (hashMb > 0) {
+        table = std::make_unique<PerftTable>(hashMb);
+    }
+
+    ThreadPool& pool = ThreadPool::instance();
+    if (threads <= 0) {
+        threads = static_cast<int>(pool.size());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    MoveList rootMoves = board.getAllPossibleMoves(board.isWhiteToMove());
+    std::vector<uint64_t> counts(rootMoves.size(), 0);
+
+    // Ходы корня — независимые: threads задач разбирают их по общему
+    // счётчику, у каждой задачи своя копия доски
+    if (threads > 1) {
+        std::atomic<size_t> nextMove{ 0 };
+        size_t workers = std::min(static_cast<size_t>(threads), rootMoves.size());
+        TaskGroup group(pool);
+        for (size_t w = 0; w < workers; ++w) {
+            group.run([&, child = board]() mutable {
+                for (size_t i = nextMove.fetch_add(1); i < rootMoves.size(); i = nextMove.fetch_add(1)) {
+                    Undo u = child.makeMoveUnchecked(rootMoves[i]);
+                    counts[i] = perft(child, depth - 1, table.get());
+                    child.unmakeMove(u);
+                }
+            });
+        }
+        group.wait();
+    }
+    else {
+        for (size_t i = 0; i < rootMoves.size(); ++i) {
+            Undo u = board.makeMoveUnchecked(rootMoves[i]);
+            counts[i] = perft(board, depth - 1, table.get());
+            board.unmakeMove(u);
+        }
+    }
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < rootMoves.size(); ++i) {
+        total += counts[i];
+        if (divide) {
+            std::cout << CheckersBoard::moveToString(rootMoves[i]) << ": " << counts[i] << "\n";
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Глубина: " << depth << "\n";
+    std::cout << "Узлов: " << total << "\n";
+    std::cout << "Время: " << seconds << " с\n";
+    std::cout << "Узлов/с: " << static_cast<uint64_t>(seconds > 0 ? total / seconds : 0) << "\n";
+    return 0;
+}
@@ -0,0 +1,77 @@
+﻿#include "../Include/ponder.h"
+#include "../Include/engine.h"
+
+void Ponder::start(const CheckersBoard& board) {
+    cancel();
+
+    CheckersBoard position = board;
+    if (!position.canCurrentPlayerMove()) {
+        return;
+    }
+    // Предсказанный ответ — следующий ход главного варианта, если он ещё возможен
+    predicted = false;
+    if (lastPv.size() >= 2) {
+        auto moves = position.getAllPossibleMoves(position.isWhiteToMove());
+        for (const auto& mv : moves) {
+            if (mv == lastPv[1]) {
+                position.makeMoveUnchecked(mv);
+                predicted = true;
+                break;
+            }
+        }
+    }
+    // После угаданного хода ответ даст книга или ходить нечем: думать не о чем
+    Move book;
+    if (predicted && (!position.canCurrentPlayerMove() || position.bookMove(book))) {
+        return;
+    }
+
+    // Фоновый поиск в статистику не пишет: строку получит только сыгранный
+    // результат — угаданный (в think) или поиск после промаха
+    position.setStatsOutput(nullptr);
+    stop = std::stop_source();
+    ponderKey = position.hash();
+    started = std::chrono::steady_clock::now();
+    pending = startSearch(position, SearchLimits(), stop.get_token());
+}
+
+void Ponder::cancel() {
+    if (pending.valid()) {
+        stop.request_stop();
+        pending.get();
+    }
+}
+
+Move Ponder::think(CheckersBoard& board) {
+    lastHit = false;
+    if (pending.valid()) {
+        if (predicted && ponderKey == board.hash()) {
+            // Ход угадан: поиск идёт с начала хода соперника, даём ему остаток бюджета
+            pending.wait_until(started + budget);
+            stop.request_stop();
+            SearchResult result = pending.get();
+            if (result.bestMove.size() > 0) {
+                board.writeStats(result);
+                ++hitCount;
+                lastHit = true;
+                lastPv = result.pv;
+                return result.bestMove;
+            }
+        }
+        else {
+            missCount += predicted;
+            cancel();
+        }
+    }
+
+    Move move;
+    if (board.bookMove(move)) {
+        lastPv.clear();
+        return move;
+    }
+    SearchLimits limits;
+    limits.budget = budget;
+    SearchResult result = startSearch(board, limits).get();
+    lastPv = result.pv;
+    return result.bestMove;
+}
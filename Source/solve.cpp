@@ -0,0 +1,133 @@
+﻿#include "../Include/checkers.h"
+#include "../Include/dfpn.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+
+// solve: точный результат позиции (выигрыш, ничья или проигрыш стороны хода)
+// решателем df-pn, с размером доказательства и временем.
+//
+//   solve [-H МБ] [-m мс] [-q полуходов] (-p "позиция" | файл_позиций | -)
+//     -p  одна позиция в записи CheckersBoard::parsePosition
+//     -H  таблица доказательств (по умолчанию 64 МБ; при заполнении — сборка мусора)
+//     -m  время на позицию в миллисекундах (0 — без ограничения)
+//     -q  правило ничьей: полуходов без рубок и ходов простыми (по умолчанию 60)
+//
+// Файл позиций — по одной в строке, пустые строки и строки с # пропускаются;
+// "-" — стандартный ввод. Отличие от поиска: ответ не зависит от оценочной
+// функции и глубины — позиция решена до конца партии по правилу ничьей.
+// Таблицы окончаний берутся из каталога tb, если он есть.
+
+namespace {
+
+const char* describe(WDL result, bool whiteToMove) {
+    if (result == WDL::DRAW) {
+        return "ничья";
+    }
+    bool whiteWins = (result == WDL::WIN) == whiteToMove;
+    return whiteWins ? "выигрыш белых" : "выигрыш чёрных";
+}
+
+bool solvePosition(ProofNumberSolver& solver, const std::string& text, std::chrono::milliseconds budget) {
+    CheckersBoard board;
+    if (!board.parsePosition(text)) {
+        std::cout << "Некорректная позиция: " << text << "\n";
+        return false;
+    }
+    SearchLimits limits;
+    limits.budget = budget;
+    SolveResult result = solver.solve(board, limits);
+
+    std::cout << "Позиция: " << board.toPositionString() << "\n";
+    if (!result.solved) {
+        std::cout << "Результат: не решено за отведённое время\n";
+    }
+    else {
+        std::cout << "Результат: " << describe(result.result, board.isWhiteToMove()) << "\n";
+        if (result.bestMove.size() > 0) {
+            std::cout << "Ход: " << CheckersBoard::moveToString(result.bestMove) << "\n";
+        }
+        std::cout << "Доказательство: " << result.proofSize << " позиций\n";
+    }
+    std::cout << "Узлов: " << result.nodes << "\n";
+    std::cout << "Сборок мусора: " << result.collections << "\n";
+    std::cout << "Время: " << result.seconds << " с\n";
+    return result.solved;
+}
+
+void printUsage() {
+    std::cout << "Использование: solve [-H МБ] [-m мс] [-q полуходов] (-p \"позиция\" | файл_позиций | -)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    setlocale(LC_ALL, "ru");
+
+    size_t hashMb = 64;
+    std::chrono::milliseconds budget{ 0 };
+    int drawPlies = ProofNumberSolver::DEFAULT_DRAW_PLIES;
+    std::string position;
+    std::string inputPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-H" && hasValue) {
+            hashMb = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-m" && hasValue) {
+            budget = std::chrono::milliseconds(std::atol(argv[++i]));
+        }
+        else if (arg == "-q" && hasValue) {
+            drawPlies = std::atoi(argv[++i]);
+        }
+        else if (arg == "-p" && hasValue) {
+            position = argv[++i];
+        }
+        else if (inputPath.empty() && (arg == "-" || arg[0] != '-')) {
+            inputPath = arg;
+        }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (hashMb == 0 || drawPlies < 1 || drawPlies > 255 || position.empty() == inputPath.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    // Позиции из таблиц окончаний решатель не перебирает
+    Tablebases::shared().load("tb");
+
+    ProofNumberSolver solver(hashMb);
+    solver.setDrawPlies(drawPlies);
+    if (!position.empty()) {
+        return solvePosition(solver, position, budget) ? 0 : 2;
+    }
+
+    std::ifstream file;
+    if (inputPath != "-") {
+        file.open(inputPath);
+        if (!file) {
+            std::cout << "Не удалось открыть " << inputPath << "\n";
+            return 1;
+        }
+    }
+    std::istream& input = inputPath == "-" ? std::cin : file;
+    std::string line;
+    bool allSolved = true;
+    bool first = true;
+    while (std::getline(input, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (!first) {
+            std::cout << "\n";
+        }
+        first = false;
+        allSolved = solvePosition(solver, line, budget) && allSolved;
+    }
+    return allSolved ? 0 : 2;
+}
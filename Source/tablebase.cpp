@@ -0,0 +1,296 @@
+﻿#include "../Include/tablebase.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+// Заголовок файла: "CTB1", состав (4 байта), число позиций (8 байт)
+const char MAGIC[4] = { 'C', 'T', 'B', '1' };
+const size_t HEADER_SIZE = 16;
+
+// Биномиальные коэффициенты C(n, k) для n <= 32, k <= MAX_PIECES
+struct Binomials {
+    uint64_t c[33][Tablebases::MAX_PIECES + 1];
+};
+
+constexpr Binomials buildBinomials() {
+    Binomials b{};
+    for (int n = 0; n <= 32; ++n) {
+        b.c[n][0] = 1;
+        for (int k = 1; k <= Tablebases::MAX_PIECES; ++k) {
+            b.c[n][k] = (n == 0) ? 0 : b.c[n - 1][k - 1] + b.c[n - 1][k];
+        }
+    }
+    return b;
+}
+
+constexpr Binomials BINOM = buildBinomials();
+
+// Номер подмножества set среди сочетаний свободных клеток free
+uint64_t rankSubset(uint32_t set, uint32_t free) {
+    uint64_t rank = 0;
+    int i = 1;
+    for (uint32_t bb = set; bb; bb &= bb - 1, ++i) {
+        int s = std::countr_zero(bb);
+        int p = std::popcount(free & ((1u << s) - 1));
+        rank += BINOM.c[p][i];
+    }
+    return rank;
+}
+
+// Обратное к rankSubset: k клеток из свободных
+uint32_t unrankSubset(uint64_t rank, int k, uint32_t free) {
+    uint32_t set = 0;
+    int p = std::popcount(free);
+    for (int i = k; i >= 1; --i) {
+        do {
+            --p;
+        } while (BINOM.c[p][i] > rank);
+        rank -= BINOM.c[p][i];
+        // p-я по счёту свободная клетка
+        uint32_t bb = free;
+        for (int j = 0; j < p; ++j) {
+            bb &= bb - 1;
+        }
+        set |= bb & (0u - bb);
+    }
+    return set;
+}
+
+} // namespace
+
+// === Material ===
+
+uint64_t Material::size() const {
+    return BINOM.c[32][whiteMen] *
+        BINOM.c[32 - whiteMen][whiteKings] *
+        BINOM.c[32 - whiteMen - whiteKings][blackMen] *
+        BINOM.c[32 - whiteMen - whiteKings - blackMen][blackKings];
+}
+
+uint64_t Material::index(uint32_t white, uint32_t black, uint32_t kings) const {
+    uint32_t wm = white & ~kings, wk = white & kings;
+    uint32_t bm = black & ~kings, bk = black & kings;
+    uint32_t free = ~0u;
+    uint64_t idx = rankSubset(wm, free);
+    free &= ~wm;
+    idx = idx * BINOM.c[std::popcount(free)][whiteKings] + rankSubset(wk, free);
+    free &= ~wk;
+    idx = idx * BINOM.c[std::popcount(free)][blackMen] + rankSubset(bm, free);
+    free &= ~bm;
+    idx = idx * BINOM.c[std::popcount(free)][blackKings] + rankSubset(bk, free);
+    return idx;
+}
+
+void Material::decode(uint64_t idx, uint32_t& white, uint32_t& black, uint32_t& kings) const {
+    int n2 = 32 - whiteMen;
+    int n3 = n2 - whiteKings;
+    int n4 = n3 - blackMen;
+    uint64_t r4 = idx % BINOM.c[n4][blackKings];
+    idx /= BINOM.c[n4][blackKings];
+    uint64_t r3 = idx % BINOM.c[n3][blackMen];
+    idx /= BINOM.c[n3][blackMen];
+    uint64_t r2 = idx % BINOM.c[n2][whiteKings];
+    uint64_t r1 = idx / BINOM.c[n2][whiteKings];
+
+    uint32_t free = ~0u;
+    uint32_t wm = unrankSubset(r1, whiteMen, free);
+    free &= ~wm;
+    uint32_t wk = unrankSubset(r2, whiteKings, free);
+    free &= ~wk;
+    uint32_t bm = unrankSubset(r3, blackMen, free);
+    free &= ~bm;
+    uint32_t bk = unrankSubset(r4, blackKings, free);
+
+    white = wm | wk;
+    black = bm | bk;
+    kings = wk | bk;
+}
+
+std::string Material::fileName() const {
+    std::string name;
+    name += static_cast<char>('0' + whiteMen);
+    name += static_cast<char>('0' + whiteKings);
+    name += static_cast<char>('0' + blackMen);
+    name += static_cast<char>('0' + blackKings);
+    return name + ".ctb";
+}
+
+Material Material::of(uint32_t white, uint32_t black, uint32_t kings) {
+    return {
+        std::popcount(white & ~kings), std::popcount(white & kings),
+        std::popcount(black & ~kings), std::popcount(black & kings)
+    };
+}
+
+// === Tablebases ===
+
+int Tablebases::load(const std::string& directory) {
+    int loaded = 0;
+    for (int wm = 0; wm <= MAX_PIECES; ++wm) {
+        for (int wk = 0; wm + wk <= MAX_PIECES; ++wk) {
+            for (int bm = 0; wm + wk + bm <= MAX_PIECES; ++bm) {
+                for (int bk = 0; wm + wk + bm + bk <= MAX_PIECES; ++bk) {
+                    if (wm + wk == 0 || bm + bk == 0) {
+                        continue;
+                    }
+                    Material m{ wm, wk, bm, bk };
+                    if (add(directory + "/" + m.fileName())) {
+                        ++loaded;
+                    }
+                }
+            }
+        }
+    }
+    return loaded;
+}
+
+bool Tablebases::add(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+
+    // Заголовок должен совпадать с именем и размером таблицы
+    const uint8_t* bytes = file.data();
+    if (file.size() < HEADER_SIZE || std::memcmp(bytes, MAGIC, 4) != 0) {
+        return false;
+    }
+    Material mat{ bytes[4], bytes[5], bytes[6], bytes[7] };
+    if (mat.pieces() > MAX_PIECES || mat.whiteMen + mat.whiteKings == 0 ||
+        mat.blackMen + mat.blackKings == 0)
+    {
+        return false;
+    }
+    uint64_t count = 0;
+    std::memcpy(&count, bytes + 8, sizeof(count));
+    if (count != mat.size() || file.size() < HEADER_SIZE + count) {
+        return false;
+    }
+
+    // Наибольшее расстояние — один проход по таблице при загрузке.
+    // Записи 127 и 255 могут быть урезанными расстояниями: точная граница неизвестна
+    const uint8_t* values = bytes + HEADER_SIZE;
+    int maxWin = 0, maxLoss = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint8_t v = values[i];
+        if (v >= 128) {
+            maxLoss = std::max<int>(maxLoss, v);
+        }
+        else {
+            maxWin = std::max<int>(maxWin, v);
+        }
+    }
+    int distance = std::max(maxWin > 0 ? decodeByte(static_cast<uint8_t>(maxWin)).distance : 0,
+        maxLoss > 0 ? decodeByte(static_cast<uint8_t>(maxLoss)).distance : 0);
+    if (maxWin == 127 || maxLoss == 255) {
+        distance = UNBOUNDED;
+    }
+
+    tables[mat.whiteMen][mat.whiteKings][mat.blackMen][mat.blackKings] = values;
+    longest[mat.whiteMen][mat.whiteKings][mat.blackMen][mat.blackKings] = distance;
+    files.push_back(std::move(file));
+    largest = std::max(largest, mat.pieces());
+    return true;
+}
+
+// Рубка уменьшает число шашек, превращение переводит простую в дамки:
+// из состава достижимы составы с не большим числом простых и шашек у каждой
+// стороны. Таблица с ходом чёрных — перевёрнутый состав.
+int Tablebases::maxDistance(uint32_t white, uint32_t black, uint32_t kings) const {
+    Material m = Material::of(white, black, kings);
+    const int limit = MAX_PIECES;
+    int result = 0;
+    for (int wm = 0; wm <= std::min(m.whiteMen, limit); ++wm) {
+        for (int wk = 0; wm + wk <= std::min(m.whiteMen + m.whiteKings, limit); ++wk) {
+            for (int bm = 0; bm <= std::min(m.blackMen, limit); ++bm) {
+                for (int bk = 0; bm + bk <= std::min(m.blackMen + m.blackKings, limit); ++bk) {
+                    if (wm + wk + bm + bk > limit) {
+                        continue;
+                    }
+                    if (tables[wm][wk][bm][bk]) {
+                        result = std::max(result, longest[wm][wk][bm][bk]);
+                    }
+                    if (tables[bm][bk][wm][wk]) {
+                        result = std::max(result, longest[bm][bk][wm][wk]);
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+bool Tablebases::probe(uint32_t white, uint32_t black, uint32_t kings, bool whiteToMove, TBEntry& out) const {
+    if (std::popcount(white | black) > largest) {
+        return false;
+    }
+    // Ходящая сторона — всегда белые
+    if (!whiteToMove) {
+        uint32_t w = rotate(black);
+        black = rotate(white);
+        white = w;
+        kings = rotate(kings);
+    }
+    if (white == 0) {
+        out = { WDL::LOSS, 0 };
+        return true;
+    }
+    if (black == 0) {
+        return false;
+    }
+    Material m = Material::of(white, black, kings);
+    const uint8_t* table = tables[m.whiteMen][m.whiteKings][m.blackMen][m.blackKings];
+    if (!table) {
+        return false;
+    }
+    out = decodeByte(table[m.index(white, black, kings)]);
+    return true;
+}
+
+uint8_t Tablebases::encode(const TBEntry& entry) {
+    switch (entry.wdl) {
+    case WDL::WIN:  return static_cast<uint8_t>(1 + std::min(entry.distance, 126));
+    case WDL::LOSS: return static_cast<uint8_t>(128 + std::min(entry.distance, 127));
+    default:        return 0;
+    }
+}
+
+TBEntry Tablebases::decodeByte(uint8_t value) {
+    if (value == 0) return { WDL::DRAW, 0 };
+    if (value < 128) return { WDL::WIN, value - 1 };
+    return { WDL::LOSS, value - 128 };
+}
+
+uint32_t Tablebases::rotate(uint32_t bb) {
+    bb = ((bb >> 1) & 0x55555555u) | ((bb & 0x55555555u) << 1);
+    bb = ((bb >> 2) & 0x33333333u) | ((bb & 0x33333333u) << 2);
+    bb = ((bb >> 4) & 0x0F0F0F0Fu) | ((bb & 0x0F0F0F0Fu) << 4);
+    bb = ((bb >> 8) & 0x00FF00FFu) | ((bb & 0x00FF00FFu) << 8);
+    return (bb >> 16) | (bb << 16);
+}
+
+bool Tablebases::write(const std::string& path, const Material& material, const std::vector<uint8_t>& values) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    uint8_t header[HEADER_SIZE] = {};
+    std::memcpy(header, MAGIC, 4);
+    header[4] = static_cast<uint8_t>(material.whiteMen);
+    header[5] = static_cast<uint8_t>(material.whiteKings);
+    header[6] = static_cast<uint8_t>(material.blackMen);
+    header[7] = static_cast<uint8_t>(material.blackKings);
+    uint64_t count = values.size();
+    std::memcpy(header + 8, &count, sizeof(count));
+    out.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+    out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size()));
+    return static_cast<bool>(out);
+}
+
+Tablebases& Tablebases::shared() {
+    static Tablebases tables;
+    return tables;
+}
@@ -0,0 +1,281 @@
+﻿#include "../Include/checkers.h"
+#include "../Include/tablebase.h"
+#include "../Include/thread_pool.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+
+// tbgen: таблицы окончаний (выигрыш/ничья/проигрыш и расстояние до смены
+// материала) для всех составов до N шашек.
+//
+//   tbgen [-n шашек] [-o каталог]
+//     -n  наибольшее число шашек на доске (по умолчанию 4, не больше Tablebases::MAX_PIECES)
+//     -o  каталог для файлов таблиц (по умолчанию tb)
+//
+// Ретроградный анализ итерациями: на шаге k решаются позиции, у которых
+// выигрыш (или проигрыш) наступает ровно через k полуходов внутри таблицы.
+// Рубки и превращения ведут в уже построенные таблицы меньшего состава
+// и считаются известными с первого шага.
+
+namespace {
+
+// Значение позиции при построении: 0 — не решена, иначе флаг и номер шага
+const uint16_t WIN_FLAG = 0x4000;
+const uint16_t LOSS_FLAG = 0x8000;
+const uint16_t INVALID = 0xC000;
+const uint16_t FLAG_MASK = 0xC000;
+const uint16_t STEP_MASK = 0x3FFF;
+
+struct Table {
+    Material material;
+    uint64_t size = 0;
+    std::unique_ptr<std::atomic<uint16_t>[]> values;
+};
+
+// Пара таблиц, которые ссылаются друг на друга: ход из одной переводит
+// (после поворота доски) в другую. Для симметричного состава пара из одной таблицы.
+class PairSolver {
+public:
+    PairSolver(const Material& m, const Tablebases& solved) : solved(solved) {
+        addTable(m);
+        if (!(m.flipped() == m)) {
+            addTable(m.flipped());
+        }
+    }
+
+    void solve(ThreadPool& pool) {
+        sweep(pool, 0);
+        for (int step = 1; step <= STEP_MASK; ++step) {
+            if (sweep(pool, step) == 0) {
+                break;
+            }
+            iterations = step;
+        }
+    }
+
+    int iterationCount() const { return iterations; }
+    size_t tableCount() const { return tables.size(); }
+    const Material& materialAt(size_t i) const { return tables[i].material; }
+
+    // Значения таблицы в формате файла
+    std::vector<uint8_t> encoded(size_t t, uint64_t counts[3]) const {
+        const Table& table = tables[t];
+        std::vector<uint8_t> out(table.size);
+        for (uint64_t i = 0; i < table.size; ++i) {
+            uint16_t v = table.values[i].load(std::memory_order_relaxed);
+            TBEntry e;
+            if ((v & FLAG_MASK) == WIN_FLAG) {
+                e = { WDL::WIN, v & STEP_MASK };
+                counts[0]++;
+            }
+            else if ((v & FLAG_MASK) == LOSS_FLAG) {
+                e = { WDL::LOSS, v & STEP_MASK };
+                counts[2]++;
+            }
+            else if (v != INVALID) {
+                counts[1]++;
+            }
+            out[i] = Tablebases::encode(e);
+        }
+        return out;
+    }
+
+private:
+    const Tablebases& solved;
+    std::vector<Table> tables;
+    int iterations = 0;
+
+    void addTable(const Material& m) {
+        Table t;
+        t.material = m;
+        t.size = m.size();
+        t.values.reset(new std::atomic<uint16_t>[t.size]);
+        for (uint64_t i = 0; i < t.size; ++i) {
+            t.values[i].store(0, std::memory_order_relaxed);
+        }
+        tables.push_back(std::move(t));
+    }
+
+    // Проход по всем нерешённым позициям; возвращает число решённых
+    uint64_t sweep(ThreadPool& pool, int step) {
+        std::atomic<uint64_t> resolved{ 0 };
+        TaskGroup group(pool);
+        for (auto& table : tables) {
+            uint64_t chunk = table.size / (8 * pool.size()) + 1;
+            for (uint64_t begin = 0; begin < table.size; begin += chunk) {
+                uint64_t end = std::min(table.size, begin + chunk);
+                group.run([this, &table, &resolved, begin, end, step]() {
+                    resolved.fetch_add(sweepRange(table, begin, end, step));
+                });
+            }
+        }
+        group.wait();
+        return resolved.load();
+    }
+
+    uint64_t sweepRange(Table& table, uint64_t begin, uint64_t end, int step) {
+        CheckersBoard board;
+        uint64_t resolved = 0;
+        for (uint64_t i = begin; i < end; ++i) {
+            if (table.values[i].load(std::memory_order_relaxed) != 0) {
+                continue;
+            }
+            uint32_t white, black, kings;
+            table.material.decode(i, white, black, kings);
+
+            // Шаг 0: недостижимые расстановки и позиции без ходов
+            if (step == 0) {
+                // Простая не может стоять на своём поле превращения
+                if ((white & ~kings & 0xF0000000u) || (black & ~kings & 0x0000000Fu)) {
+                    table.values[i].store(INVALID, std::memory_order_relaxed);
+                    continue;
+                }
+                board.setPosition(white, black, kings, true);
+                if (!board.canCurrentPlayerMove()) {
+                    table.values[i].store(LOSS_FLAG, std::memory_order_relaxed);
+                    ++resolved;
+                }
+                continue;
+            }
+
+            board.setPosition(white, black, kings, true);
+            MoveList moves = board.getAllPossibleMoves(true);
+            bool win = false;
+            bool allLose = true;
+            for (const auto& mv : moves) {
+                Undo u = board.makeMoveUnchecked(mv);
+                uint16_t child = childValue(board, step);
+                board.unmakeMove(u);
+                if ((child & FLAG_MASK) == LOSS_FLAG) {
+                    win = true;
+                    break;
+                }
+                if ((child & FLAG_MASK) != WIN_FLAG) {
+                    allLose = false;
+                }
+            }
+            if (win || allLose) {
+                table.values[i].store(static_cast<uint16_t>((win ? WIN_FLAG : LOSS_FLAG) | step),
+                    std::memory_order_relaxed);
+                ++resolved;
+            }
+        }
+        return resolved;
+    }
+
+    // Значение позиции после хода (ходят чёрные) для ходящей стороны.
+    // Решённые на текущем шаге позиции не учитываются: так номер шага
+    // равен расстоянию, а результат не зависит от порядка потоков.
+    uint16_t childValue(const CheckersBoard& board, int step) const {
+        uint32_t white = Tablebases::rotate(board.blackPieces());
+        uint32_t black = Tablebases::rotate(board.whitePieces());
+        uint32_t kings = Tablebases::rotate(board.kingPieces());
+        if (white == 0) {
+            return LOSS_FLAG;
+        }
+        Material m = Material::of(white, black, kings);
+        for (const auto& table : tables) {
+            if (table.material == m) {
+                uint16_t v = table.values[m.index(white, black, kings)].load(std::memory_order_relaxed);
+                return (v & STEP_MASK) < step ? v : 0;
+            }
+        }
+        // Рубка или превращение: таблица меньшего состава уже построена
+        TBEntry e;
+        if (!solved.probe(white, black, kings, true, e)) {
+            std::cout << "Нет таблицы " << m.fileName() << "\n";
+            std::exit(1);
+        }
+        return e.wdl == WDL::WIN ? WIN_FLAG : e.wdl == WDL::LOSS ? LOSS_FLAG : 0;
+    }
+};
+
+// Составы до pieces шашек в порядке построения: сперва меньше шашек,
+// при равном числе — меньше простых (превращение уменьшает их число)
+std::vector<Material> buildOrder(int pieces) {
+    std::vector<Material> order;
+    for (int n = 2; n <= pieces; ++n) {
+        for (int men = 0; men <= n; ++men) {
+            for (int wm = 0; wm <= men; ++wm) {
+                for (int wk = 0; wm + wk + (men - wm) <= n; ++wk) {
+                    Material m{ wm, wk, men - wm, n - men - wk };
+                    if (m.whiteMen + m.whiteKings == 0 || m.blackMen + m.blackKings == 0) {
+                        continue;
+                    }
+                    // Пара строится вместе с зеркальным составом
+                    bool seen = false;
+                    for (const auto& other : order) {
+                        seen = seen || other == m.flipped();
+                    }
+                    if (!seen) {
+                        order.push_back(m);
+                    }
+                }
+            }
+        }
+    }
+    return order;
+}
+
+void printUsage() {
+    std::cout << "Использование: tbgen [-n шашек] [-o каталог]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    setlocale(LC_ALL, "ru");
+
+    int pieces = 4;
+    std::string directory = "tb";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) {
+            pieces = std::atoi(argv[++i]);
+        }
+        else if (arg == "-o" && i + 1 < argc) {
+            directory = argv[++i];
+        }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (pieces < 2 || pieces > Tablebases::MAX_PIECES) {
+        printUsage();
+        return 1;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+
+    ThreadPool& pool = ThreadPool::instance();
+    Tablebases solved;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const Material& m : buildOrder(pieces)) {
+        auto t0 = std::chrono::steady_clock::now();
+        PairSolver solver(m, solved);
+        solver.solve(pool);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        for (size_t t = 0; t < solver.tableCount(); ++t) {
+            const Material& mat = solver.materialAt(t);
+            uint64_t counts[3] = {};
+            std::vector<uint8_t> values = solver.encoded(t, counts);
+            std::string path = directory + "/" + mat.fileName();
+            if (!Tablebases::write(path, mat, values) || !solved.add(path)) {
+                std::cout << "Не удалось записать " << path << "\n";
+                return 1;
+            }
+            std::cout << mat.fileName() << ": позиций " << values.size()
+                << ", выигрыш " << counts[0] << ", ничья " << counts[1] << ", проигрыш " << counts[2]
+                << ", итераций " << solver.iterationCount() << ", " << seconds << " с\n";
+        }
+    }
+
+    double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Готово за " << total << " с\n";
+    return 0;
+}
@@ -0,0 +1,139 @@
+﻿#include "../Include/thread_pool.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+// Номер очереди текущего потока пула; -1 — поток не из пула
+thread_local int currentWorker = -1;
+thread_local const ThreadPool* currentPool = nullptr;
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        threads.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task, const void* owner) {
+    unsigned q = (currentPool == this && currentWorker >= 0)
+        ? static_cast<unsigned>(currentWorker)
+        : nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+    // Счётчик растёт до публикации задачи: взявший её поток уменьшает его
+    // уже после, и pending не уходит ниже нуля
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        pending.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[q]->m);
+        queues[q]->tasks.push_back(Task{ std::move(task), owner });
+    }
+    wakeUp.notify_one();
+}
+
+// Своя очередь — с конца, затем кража из чужих — с начала.
+// С меткой owner берётся ближайшая к тому же краю задача этого владельца
+bool ThreadPool::takeTask(unsigned self, const void* owner, std::function<void()>& task) {
+    unsigned n = size();
+    if (self < n) {
+        WorkQueue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.m);
+        for (auto it = own.tasks.rbegin(); it != own.tasks.rend(); ++it) {
+            if (owner == nullptr || it->owner == owner) {
+                task = std::move(it->run);
+                own.tasks.erase(std::next(it).base());
+                pending.fetch_sub(1);
+                return true;
+            }
+        }
+    }
+    for (unsigned k = 1; k <= n; ++k) {
+        WorkQueue& victim = *queues[(self + k) % n];
+        std::lock_guard<std::mutex> lock(victim.m);
+        for (auto it = victim.tasks.begin(); it != victim.tasks.end(); ++it) {
+            if (owner == nullptr || it->owner == owner) {
+                task = std::move(it->run);
+                victim.tasks.erase(it);
+                pending.fetch_sub(1);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::runPendingTask(const void* owner) {
+    if (pending.load() == 0) {
+        return false;
+    }
+    unsigned self = (currentPool == this && currentWorker >= 0)
+        ? static_cast<unsigned>(currentWorker) : size();
+    std::function<void()> task;
+    if (!takeTask(self, owner, task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(unsigned index) {
+    currentWorker = static_cast<int>(index);
+    currentPool = this;
+    while (true) {
+        std::function<void()> task;
+        if (takeTask(index, nullptr, task)) {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return stopping || pending.load() > 0; });
+        if (stopping && pending.load() == 0) {
+            return;
+        }
+    }
+}
+
+unsigned ThreadPool::fairShare() const {
+    unsigned searches = std::max(1u, sharers.load());
+    return std::max(1u, size() / searches);
+}
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool(std::thread::hardware_concurrency());
+    return pool;
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    unfinished.fetch_add(1);
+    pool.submit([this, task = std::move(task)]() {
+        task();
+        unfinished.fetch_sub(1);
+    }, this);
+}
+
+void TaskGroup::wait() {
+    while (unfinished.load() > 0) {
+        if (!pool.runPendingTask(this)) {
+            std::this_thread::yield();
+        }
+    }
+}
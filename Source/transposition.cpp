@@ -0,0 +1,168 @@
+﻿#include "../Include/transposition.h"
+#include <limits>
+
+namespace {
+
+// Упаковка записи в 64 бита:
+// [0..15] оценка, [16..23] глубина, [24..25] граница,
+// [26..41] номер хода + 1, [42..49] поколение, [63] признак занятости
+const uint64_t USED_BIT = 1ull << 63;
+
+uint64_t packData(int score, int depth, Bound bound, int moveIndex, uint8_t gen) {
+    // Номер, не помещающийся в 16 бит, записывается как «хода нет»
+    if (moveIndex >= 0xFFFF) {
+        moveIndex = -1;
+    }
+    uint64_t d = static_cast<uint16_t>(static_cast<int16_t>(score));
+    d |= static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 16;
+    d |= static_cast<uint64_t>(bound) << 24;
+    d |= static_cast<uint64_t>(static_cast<uint16_t>(moveIndex + 1)) << 26;
+    d |= static_cast<uint64_t>(gen) << 42;
+    return d | USED_BIT;
+}
+
+int dataDepth(uint64_t d) { return static_cast<int>((d >> 16) & 0xFF); }
+uint8_t dataGeneration(uint64_t d) { return static_cast<uint8_t>((d >> 42) & 0xFF); }
+
+void unpackData(uint64_t d, TTEntry& e) {
+    e.score = static_cast<int16_t>(d & 0xFFFF);
+    e.depth = dataDepth(d);
+    e.bound = static_cast<Bound>((d >> 24) & 0x3);
+    e.moveIndex = static_cast<int>((d >> 26) & 0xFFFF) - 1;
+}
+
+// Номер полосы счётчиков для текущего потока
+unsigned counterShard() {
+    static std::atomic<unsigned> next{ 0 };
+    thread_local unsigned shard = next.fetch_add(1, std::memory_order_relaxed);
+    return shard;
+}
+
+} // namespace
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    counters.reset(new Counters[COUNTER_SHARDS]);
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+    // Число корзин — степень двойки, чтобы индекс брался маской
+    size_t want = (megabytes * 1024 * 1024) / sizeof(Bucket);
+    size_t count = 1;
+    while (count * 2 <= want) {
+        count *= 2;
+    }
+    buckets.reset(new Bucket[count]);
+    bucketCount = count;
+    resetStats();
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < bucketCount; ++i) {
+        for (auto& slot : buckets[i].slots) {
+            slot.keyXorData.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+size_t TranspositionTable::sizeInBytes() const {
+    return bucketCount * sizeof(Bucket);
+}
+
+void TranspositionTable::newSearch() {
+    generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+TranspositionTable::Bucket& TranspositionTable::bucketFor(uint64_t key) const {
+    return buckets[key & (bucketCount - 1)];
+}
+
+TranspositionTable::Counters& TranspositionTable::localCounters() const {
+    return counters[counterShard() % COUNTER_SHARDS];
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& out) {
+    Counters& cnt = localCounters();
+    cnt.probes.fetch_add(1, std::memory_order_relaxed);
+
+    for (auto& slot : bucketFor(key).slots) {
+        uint64_t d = slot.data.load(std::memory_order_relaxed);
+        uint64_t k = slot.keyXorData.load(std::memory_order_relaxed);
+        if (d != 0 && (k ^ d) == key) {
+            unpackData(d, out);
+            cnt.hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int score, int depth, Bound bound, int moveIndex) {
+    Counters& cnt = localCounters();
+    uint8_t gen = generation.load(std::memory_order_relaxed);
+    Bucket& b = bucketFor(key);
+
+    // Та же позиция — обновляем, иначе вытесняем самую мелкую и старую запись
+    Slot* target = nullptr;
+    int worst = std::numeric_limits<int>::max();
+    for (auto& slot : b.slots) {
+        uint64_t d = slot.data.load(std::memory_order_relaxed);
+        uint64_t k = slot.keyXorData.load(std::memory_order_relaxed);
+        if (d != 0 && (k ^ d) == key) {
+            if (depth < dataDepth(d) && bound != Bound::EXACT && dataGeneration(d) == gen) {
+                return;
+            }
+            target = &slot;
+            break;
+        }
+        int age = static_cast<uint8_t>(gen - dataGeneration(d));
+        int priority = (d == 0) ? std::numeric_limits<int>::min() : dataDepth(d) - 8 * age;
+        if (priority < worst) {
+            worst = priority;
+            target = &slot;
+        }
+    }
+
+    uint64_t old = target->data.load(std::memory_order_relaxed);
+    uint64_t oldKey = target->keyXorData.load(std::memory_order_relaxed) ^ old;
+    if (old != 0 && oldKey != key) {
+        cnt.collisions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t data = packData(score, depth, bound, moveIndex, gen);
+    target->keyXorData.store(key ^ data, std::memory_order_relaxed);
+    target->data.store(data, std::memory_order_relaxed);
+    cnt.stores.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TranspositionTable::recordCutoff() {
+    localCounters().cutoffs.fetch_add(1, std::memory_order_relaxed);
+}
+
+TTStats TranspositionTable::stats() const {
+    TTStats s;
+    for (int i = 0; i < COUNTER_SHARDS; ++i) {
+        s.probes += counters[i].probes.load(std::memory_order_relaxed);
+        s.hits += counters[i].hits.load(std::memory_order_relaxed);
+        s.cutoffs += counters[i].cutoffs.load(std::memory_order_relaxed);
+        s.stores += counters[i].stores.load(std::memory_order_relaxed);
+        s.collisions += counters[i].collisions.load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+void TranspositionTable::resetStats() {
+    for (int i = 0; i < COUNTER_SHARDS; ++i) {
+        counters[i].probes.store(0, std::memory_order_relaxed);
+        counters[i].hits.store(0, std::memory_order_relaxed);
+        counters[i].cutoffs.store(0, std::memory_order_relaxed);
+        counters[i].stores.store(0, std::memory_order_relaxed);
+        counters[i].collisions.store(0, std::memory_order_relaxed);
+    }
+}
+
+TranspositionTable& TranspositionTable::shared() {
+    static TranspositionTable table;
+    return table;
+}